@@ -0,0 +1,42 @@
+#ifndef BLOCKING_EXECUTOR_H
+#define BLOCKING_EXECUTOR_H
+
+#include <boost/asio/thread_pool.hpp>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+
+// Bounded pool of worker threads for handlers that block (sleeping, disk
+// reads, ...), so they never occupy the threads running the io_service.
+//
+// At most max_pending tasks may be queued or running at once; submit()
+// refuses work beyond that so a burst of slow requests cannot grow the
+// queue without limit.
+class BlockingExecutor {
+public:
+    static constexpr size_t kDefaultThreads = 16;
+    static constexpr size_t kDefaultMaxPending = 1024;
+
+    explicit BlockingExecutor(size_t num_threads = kDefaultThreads,
+                              size_t max_pending = kDefaultMaxPending);
+
+    // Waits for queued and running tasks to finish
+    ~BlockingExecutor();
+
+    BlockingExecutor(const BlockingExecutor&) = delete;
+    BlockingExecutor& operator=(const BlockingExecutor&) = delete;
+
+    // Runs task on a worker thread; the task must not throw. Returns false,
+    // without running it, when the executor is already at max_pending.
+    bool submit(std::function<void()> task);
+
+    // Number of tasks queued or running
+    size_t pending() const { return pending_.load(); }
+
+private:
+    boost::asio::thread_pool pool_;
+    size_t max_pending_;
+    std::atomic<size_t> pending_{0};
+};
+
+#endif
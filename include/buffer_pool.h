@@ -0,0 +1,71 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Pool of socket read buffers shared by all sessions.
+//
+// Buffers come in power-of-two size classes between kMinBufferSize and
+// kMaxBufferSize. Released buffers are kept on a per-class free list (up to
+// max_cached_per_class of them) so sessions can grow and shrink their read
+// buffer without going back to the allocator every time.
+class BufferPool {
+public:
+    static constexpr size_t kMinBufferSize = 1024;
+    static constexpr size_t kMaxBufferSize = 64 * 1024;
+
+    // Move-only handle to a pooled buffer. Returns the memory to its pool
+    // when destroyed or reassigned; the pool must outlive the handle.
+    class Buffer {
+    public:
+        Buffer() = default;
+        ~Buffer();
+
+        Buffer(Buffer&& other) noexcept;
+        Buffer& operator=(Buffer&& other) noexcept;
+        Buffer(const Buffer&) = delete;
+        Buffer& operator=(const Buffer&) = delete;
+
+        char* data() { return data_.get(); }
+        size_t size() const { return size_; }
+        explicit operator bool() const { return data_ != nullptr; }
+
+    private:
+        friend class BufferPool;
+        Buffer(BufferPool* pool, std::unique_ptr<char[]> data, size_t size);
+        void release();
+
+        BufferPool* pool_ = nullptr;
+        std::unique_ptr<char[]> data_;
+        size_t size_ = 0;
+    };
+
+    explicit BufferPool(size_t max_cached_per_class = 256);
+
+    // Returns a buffer of at least min_size bytes, clamped to the supported
+    // size classes.
+    Buffer acquire(size_t min_size);
+
+    // Rounds a request up to the size class acquire() would hand out.
+    static size_t size_class(size_t min_size);
+
+    // Number of idle buffers currently held by the pool (for tests/metrics).
+    size_t cached_buffers() const;
+
+private:
+    void recycle(std::unique_ptr<char[]> data, size_t size);
+    static size_t class_index(size_t size);
+
+    struct FreeList {
+        mutable std::mutex mutex;
+        std::vector<std::unique_ptr<char[]>> buffers;
+    };
+
+    size_t max_cached_per_class_;
+    std::vector<FreeList> free_lists_;
+};
+
+#endif
@@ -22,6 +22,12 @@ public:
 
     HttpResponse handle_request(const HttpRequest& request) override;
 
+    // Chunked POST and PUT bodies are collected as they arrive. Other
+    // methods do not use a body, so theirs is dropped instead of buffered.
+    std::unique_ptr<BodySink> begin_body(const HttpRequest& head) override;
+
+    HttpResponse handle_streamed_request(const HttpRequest& request, BodySink& body) override;
+
     std::string get_handler_name() const override;
 
 private:
@@ -0,0 +1,94 @@
+#ifndef DIRECTORY_WATCHER_H
+#define DIRECTORY_WATCHER_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+// Watches directories with inotify and reports, from a background thread,
+// every name in them that is written, created, replaced or removed. Used by
+// the caches in front of the filesystem to drop what they know about a path
+// as soon as it changes.
+//
+// One watcher, with one inotify instance and one thread, serves any number
+// of subscribers; the caches all share the process-wide one from shared(),
+// so the number of caches is not bounded by the inotify instance limit.
+// Each directory is watched once however many subscribers asked for it, and
+// its events go to those subscribers only.
+class DirectoryWatcher {
+public:
+    struct Callbacks {
+        // Something happened to this path (a file or directory)
+        std::function<void(const std::string& path)> changed;
+        // The directory itself was removed or moved; its watch is gone
+        std::function<void(const std::string& directory)> removed;
+        // Events were lost, so nothing learned so far can be trusted
+        std::function<void()> overflow;
+    };
+
+    using Subscription = uint64_t;
+
+    DirectoryWatcher();
+
+    // Stops the watcher thread
+    ~DirectoryWatcher();
+
+    DirectoryWatcher(const DirectoryWatcher&) = delete;
+    DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+    // The watcher shared by every cache in the process, created on first use
+    // and stopped once the last one lets go of it
+    static std::shared_ptr<DirectoryWatcher> shared();
+
+    // False if inotify is unavailable; watch() then always fails
+    bool active() const { return inotify_fd_ >= 0; }
+
+    // Callbacks run on the watcher thread without the watcher's lock held,
+    // so they may call watch(), but not subscribe() or unsubscribe()
+    Subscription subscribe(Callbacks callbacks);
+
+    // Drops the subscriber and every watch only it needed. Once this
+    // returns, none of its callbacks is running or will run again.
+    void unsubscribe(Subscription subscription);
+
+    // Starts watching directory for the subscriber unless it already is;
+    // false if it cannot be watched (missing, not a directory, out of
+    // watches)
+    bool watch(Subscription subscription, const std::string& directory);
+
+    // Directories being watched (for tests/metrics)
+    size_t watches() const;
+
+    static std::string parent_directory(const std::string& path);
+    static std::string join_path(const std::string& directory, const std::string& name);
+
+private:
+    struct Watch {
+        int wd = -1;
+        std::set<Subscription> subscribers;
+    };
+
+    void run();
+
+    // Held while callbacks run, so unsubscribe() can wait them out. Taken
+    // before mutex_ wherever both are needed.
+    std::mutex dispatch_mutex_;
+
+    // Subscribers and watched directories, both ways round
+    mutable std::mutex mutex_;
+    Subscription next_subscription_ = 1;
+    std::unordered_map<Subscription, Callbacks> subscribers_;
+    std::unordered_map<std::string, Watch> watches_;
+    std::unordered_map<int, std::string> watched_dirs_;
+
+    int inotify_fd_ = -1;
+    int wake_fd_ = -1;  // eventfd that stops the watcher thread
+    std::thread thread_;
+};
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef FILE_CACHE_H
+#define FILE_CACHE_H
+
+#include "directory_watcher.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// In-memory cache of small static files, shared by all threads serving a
+// location.
+//
+// Entries hold the file contents together with their response headers and
+// are evicted least-recently-used once the cached bytes exceed max_bytes.
+// Every directory holding a cached file is watched with inotify, through a
+// DirectoryWatcher shared with the other caches; its thread drops entries as
+// soon as their file is written, replaced or removed. Without inotify the
+// cache stays empty.
+class FileCache {
+public:
+    // Another file an entry was built from, as it was when read
+    struct Dependency {
+        std::string path;
+        bool exists = false;
+        int64_t mtime_ns = 0;
+        uint64_t size = 0;
+    };
+
+    struct Entry {
+        std::string body;
+        std::map<std::string, std::string> headers;
+
+        // What the file looked like before it was read
+        int64_t mtime_ns = 0;
+        uint64_t size = 0;
+
+        // Validator of body
+        std::string etag;
+
+        // Serialized status line and headers of the 200 for body, so a hit
+        // only has to write it
+        std::string head;
+
+        // Compressed representation, with the validators of the file it
+        // came from
+        struct Encoding {
+            std::string body;
+            std::string etag;
+            int64_t mtime_ns = 0;
+            std::string head;
+        };
+
+        // By content coding ("br", "gzip")
+        std::map<std::string, Encoding> encodings;
+
+        // Files that, when changed, created or removed, also invalidate
+        // this entry (e.g. precompressed siblings)
+        std::vector<Dependency> dependencies;
+
+        // Bytes charged against the cache budget
+        size_t cost() const;
+    };
+
+    explicit FileCache(size_t max_bytes,
+                       std::shared_ptr<DirectoryWatcher> watcher = DirectoryWatcher::shared());
+
+    // Unsubscribes from the watcher, dropping the watches only this cache used
+    ~FileCache();
+
+    FileCache(const FileCache&) = delete;
+    FileCache& operator=(const FileCache&) = delete;
+
+    // Cached entry for path, or nullptr; a hit makes it most recently used
+    std::shared_ptr<const Entry> lookup(const std::string& path);
+
+    // Caches entry for path, unless the file or one of its dependencies no
+    // longer matches what the entry was read from, or the entry exceeds the
+    // budget
+    void insert(const std::string& path, std::shared_ptr<const Entry> entry);
+
+    void invalidate(const std::string& path);
+
+    void clear();
+
+    // Fills in mtime_ns, size and, if given, inode; false if path is not a
+    // regular file
+    static bool stat_file(const std::string& path, int64_t& mtime_ns, uint64_t& size,
+                          uint64_t* inode = nullptr);
+
+    bool watching() const { return watcher_->active(); }
+    size_t bytes() const;
+    size_t entries() const;
+    size_t max_bytes() const { return max_bytes_; }
+
+private:
+    using LruList = std::list<std::string>;
+
+    struct Slot {
+        std::shared_ptr<const Entry> entry;
+        LruList::iterator lru;
+    };
+
+    bool watch_directory(const std::string& directory);
+    void drop_directory(const std::string& directory);
+    bool unchanged(const std::string& path, bool exists, int64_t mtime_ns, uint64_t size) const;
+    void invalidate_locked(const std::string& path);
+    void remove_locked(std::unordered_map<std::string, Slot>::iterator it);
+
+    const size_t max_bytes_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Slot> entries_;
+    LruList lru_;  // most recently used first
+    size_t bytes_ = 0;
+
+    // Dependency path -> keys of the entries depending on it
+    std::unordered_multimap<std::string, std::string> dependents_;
+
+    std::shared_ptr<DirectoryWatcher> watcher_;
+    DirectoryWatcher::Subscription subscription_ = 0;
+};
+
+#endif
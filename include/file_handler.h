@@ -3,8 +3,18 @@
 
 #include "http_response.h"
 #include "request_handler.h"
+#include "file_cache.h"
+#include "mapped_file.h"
+#include "stat_cache.h"
+#include <map>
+#include <memory>
+#include <optional>
 #include <string>
 #include <unordered_set>
+#include <utility>
+#include <vector>
+
+struct ByteRange;
 
 // This class handles any requests by redirecting the request and respond with file requested
 // This implements the functionality for the webserver from 
@@ -19,20 +29,128 @@ class FileHandler : public RequestHandler {
                 const std::string& route_prefix,
                 const std::unordered_set<std::string>& supported_extensions);
 
+    ~FileHandler() override;
+
+    FileHandler(const FileHandler&) = delete;
+    FileHandler& operator=(const FileHandler&) = delete;
+
     HttpResponse handle_request(const HttpRequest& request) override;
 
     std::string get_handler_name() const override;
 
+    // Files of at least this many bytes are streamed instead of read into
+    // the response body
+    void set_stream_threshold(size_t bytes) { stream_threshold_ = bytes; }
+
+    static constexpr size_t kDefaultStreamThreshold = 64 * 1024;
+
+    // Keeps up to max_bytes of files below the stream threshold in memory
+    // ("cache_size" in the location); 0 turns the cache off
+    void enable_cache(size_t max_bytes);
+
+    FileCache* cache() const { return cache_.get(); }
+
+    // Serves files of at least min_bytes from a memory mapping shared by
+    // all requests for the file ("mmap_threshold" in the location); 0 turns
+    // mapping off
+    void enable_mmap(size_t min_bytes);
+
+    MappingCache* mappings() const { return mappings_.get(); }
+
+    // Remembers up to max_entries stat() results, including misses
+    // ("stat_cache" and "stat_cache_ttl" in the location); 0 turns it off
+    void enable_stat_cache(size_t max_entries,
+                           std::chrono::milliseconds ttl = StatCache::kDefaultTtl);
+
+    StatCache* stat_cache() const { return stat_cache_.get(); }
+
   private:
     std::string root_;  
+    // O_PATH descriptor of root_; files are opened relative to it
+    int root_fd_ = -1;
+    // Whether openat2() works here, found out once by open_root()
+    bool use_openat2_ = false;
     std::string route_prefix_;
     std::unordered_set<std::string> supported_extensions_; 
+    size_t stream_threshold_ = kDefaultStreamThreshold;
+    std::unique_ptr<FileCache> cache_;
+    size_t mmap_threshold_ = 0;
+    std::unique_ptr<MappingCache> mappings_;
+    std::unique_ptr<StatCache> stat_cache_;
+
+    // Opens root_fd_ and checks whether openat2() can be used
+    void open_root();
+
+    // Metadata of relative_path, from the stat cache if there is one. Like
+    // everything else it is looked up beneath the root, so a symlink out of
+    // it reads as missing.
+    StatCache::Result stat_path(const std::string& relative_path) const;
+
+    // Opens relative_path with flags without leaving the root (the kernel
+    // refuses "..", absolute symlinks and symlinks pointing outside)
+    int open_beneath_root(const std::string& relative_path, int flags) const;
+
+    // fstat() of relative_path opened beneath the root
+    StatCache::Result stat_beneath_root(const std::string& relative_path) const;
+
+    // Opens relative_path for reading beneath the root and fstat()s it into
+    // result. -1, with result.exists false, on failure.
+    int open_file(const std::string& relative_path, StatCache::Result& result) const;
     
     std::string get_mime_type(const std::string& file_path) const;
     
     bool is_supported_file_type(const std::string& file_path) const;
     
     std::string sanitize_path(const std::string& path) const;
+
+    // Text-like types worth gzipping on the fly
+    static bool is_compressible(const std::string& mime_type);
+
+    // Content coding and file suffix of precompressed siblings, best first
+    static const std::vector<std::pair<std::string, std::string>> kPrecompressedSiblings;
+
+    // Shared mapping of path if mapping is on and the file is big enough,
+    // otherwise (or if mapping fails) nullptr
+    std::shared_ptr<const MappedFile> map_file(const std::string& path, int fd, uint64_t inode,
+                                               uint64_t size, int64_t mtime_ns) const;
+
+    // Responses get their own duplicate of fd
+    HttpResponse serve_file(int fd, uint64_t file_size,
+                            const std::map<std::string, std::string>& headers,
+                            const std::shared_ptr<const MappedFile>& mapping) const;
+
+    std::shared_ptr<FileCache::Entry> load_entry(const std::string& full_path, const std::string& relative_path,
+                                                 int fd, const StatCache::Result& file_stat,
+                                                 const std::map<std::string, std::string>& headers) const;
+
+    HttpResponse respond_from_entry(const std::shared_ptr<const FileCache::Entry>& entry,
+                                    const HttpRequest& request, const std::string& accept_encoding) const;
+
+    // Status line and headers of the 200 for one representation of a file
+    static std::string prepare_head(const std::map<std::string, std::string>& headers, size_t body_size,
+                                    const std::string& etag, int64_t mtime_ns, const std::string& coding);
+
+    static std::string make_etag(uint64_t inode, uint64_t size, int64_t mtime_ns,
+                                 const std::string& coding);
+
+    // Whether the request's If-None-Match / If-Modified-Since say the
+    // client already has this representation
+    static bool is_not_modified(const HttpRequest& request, const std::string& etag, int64_t mtime_ns);
+
+    static bool is_range_request(const HttpRequest& request);
+
+    static std::optional<std::vector<ByteRange>> requested_ranges(const HttpRequest& request,
+            uint64_t size, const std::string& etag, int64_t mtime_ns);
+
+    HttpResponse range_response(const std::map<std::string, std::string>& headers,
+                                const std::vector<ByteRange>& ranges, uint64_t size,
+                                const std::string* body, int fd,
+                                const std::shared_ptr<const MappedFile>& mapping) const;
+
+    static std::string make_boundary();
+
+    static HttpResponse not_modified(const std::map<std::string, std::string>& headers,
+                                     const std::string& etag, int64_t mtime_ns);
 };
 
 #endif
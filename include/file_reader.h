@@ -0,0 +1,45 @@
+#ifndef FILE_READER_H
+#define FILE_READER_H
+
+#include "blocking_executor.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <sys/types.h>
+
+// Reads from files without blocking the calling thread, so a cold page
+// cache or a slow disk cannot stall an I/O thread.
+//
+// Two backends: io_uring, with one ring shared by every caller and a thread
+// reaping its completions, and a fallback that runs pread() on the
+// BlockingExecutor. create() picks io_uring when the kernel allows it.
+class FileReader {
+public:
+    // Bytes read (0 at end of file), or -errno
+    using Completion = std::function<void(ssize_t result)>;
+
+    virtual ~FileReader() = default;
+
+    // Reads up to length bytes at offset of fd into data. fd and data must
+    // stay valid until done has run; done runs on some other thread and
+    // should only hand the result back (e.g. post it to a strand). Returns
+    // false, without calling done, if the read could not be queued.
+    virtual bool read(int fd, uint64_t offset, char* data, size_t length, Completion done) = 0;
+
+    // "io_uring" or "threads"
+    virtual const char* backend() const = 0;
+
+    // io_uring with room for entries reads in flight, overflowing to
+    // executor; or executor alone if io_uring is unavailable
+    static std::shared_ptr<FileReader> create(std::shared_ptr<BlockingExecutor> executor,
+                                              unsigned entries = 256);
+
+    // Just the io_uring backend, or nullptr if the kernel refuses it
+    static std::shared_ptr<FileReader> create_io_uring(unsigned entries,
+                                                       std::shared_ptr<FileReader> overflow = nullptr);
+
+    static std::shared_ptr<FileReader> create_threaded(std::shared_ptr<BlockingExecutor> executor);
+};
+
+#endif
@@ -29,7 +29,8 @@ public:
     // List all existing IDs for the given entity.
     virtual std::vector<std::string> list_entity_ids(const Entity& entity) const = 0;
 
-    // Compute the next available ID (as a string) for the given entity.
+    // Reserve a new ID (as a string) for the given entity. Concurrent
+    // callers never get the same ID.
     virtual std::string next_entity_id(const Entity& entity) const = 0;
 };
 
@@ -12,6 +12,10 @@ public:
 
     // Helper to parse comma-separated extensions
     std::unordered_set<std::string> parse_extensions(const std::string& ext_string) const;
+
+private:
+    // Builds the handler for config.type, before per-location overrides
+    std::unique_ptr<RequestHandler> create_typed_handler(const HandlerConfig& config, const std::string& path) const;
 };
 
 #endif
\ No newline at end of file
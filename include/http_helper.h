@@ -1,7 +1,12 @@
 #ifndef HTTP_HELPER_H
 #define HTTP_HELPER_H
 
+#include <cstdint>
+#include <ctime>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 #include <boost/asio.hpp>
 #include "http_response.h"
 
@@ -15,4 +20,39 @@ bool detect_http_request(std::string& buffer);
 
 MalformedType check_malformed_request(const std::string& buffer);
 
+// ASCII case-insensitive comparison, used for header names.
+bool iequals(std::string_view a, std::string_view b);
+
+// Standard reason phrase for a status code, "Unknown" if we never send it.
+std::string reason_phrase(int status_code);
+
+// Whether an Accept-Encoding value allows the given content coding, i.e. it
+// lists the coding (or "*") without q=0. A named coding overrides "*".
+bool accepts_encoding(std::string_view accept_encoding, std::string_view coding);
+
+// IMF-fixdate, e.g. "Sun, 06 Nov 1994 08:49:37 GMT"
+std::string http_date(time_t time);
+
+// Parses an IMF-fixdate; nullopt for anything else
+std::optional<time_t> parse_http_date(std::string_view date);
+
+// Whether an If-None-Match value matches etag, using the weak comparison
+// (W/ prefixes ignored). "*" matches any etag.
+bool etag_matches(std::string_view if_none_match, std::string_view etag);
+
+struct ByteRange {
+    uint64_t offset;
+    uint64_t length;
+};
+
+// Ranges beyond this many are not worth a multipart response; the whole
+// representation is sent instead
+constexpr size_t kMaxByteRanges = 16;
+
+// Parses a Range header ("bytes=0-99,-500") against a representation of
+// size bytes, clamping each range to it. nullopt if the header is malformed,
+// not in bytes or asks for too many ranges, in which case it is ignored; an
+// empty vector if no range is satisfiable (416).
+std::optional<std::vector<ByteRange>> parse_byte_ranges(std::string_view range, uint64_t size);
+
 #endif
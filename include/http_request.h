@@ -2,6 +2,7 @@
 #define HTTP_REQUEST_H
 
 #include <string>
+#include <string_view>
 #include <map>
 #include <vector>
 #include <optional>
@@ -12,7 +13,8 @@ public:
     // Constructors
     HttpRequest() = default;
     
-    // Parse from raw HTTP request string
+    // Parse from raw HTTP request string (everything after the headers is
+    // the body). Session uses HttpRequestParser directly.
     static HttpRequest parse(const std::string& raw_request);
     
     // Getters
@@ -20,7 +22,7 @@ public:
     const std::string& path() const { return path_; }
     const std::string base_path() const { return base_path_; }
     const std::string& version() const { return version_; }
-    const std::string& body() const { return body_; }
+    std::string_view body() const;
     const std::string& raw_request() const { return raw_request_; }
     
     // Header access
@@ -39,7 +41,10 @@ public:
         parse_path_and_query();
     }
     void set_version(const std::string& version) { version_ = version; }
-    void set_body(const std::string& body) { body_ = body; }
+    void set_body(const std::string& body) {
+        body_ = body;
+        body_in_raw_ = false;
+    }
     void add_header(const std::string& name, const std::string& value);
 
     // Param methods
@@ -50,6 +55,8 @@ public:
     std::string to_string() const;
 
 private:
+    friend class HttpRequestParser;
+
     std::string method_;
     std::string path_;
     std::string base_path_;
@@ -58,11 +65,16 @@ private:
     std::map<std::string, std::string> headers_;
     std::string raw_request_;
 
-    std::map<std::string, std::string> query_params_;
+    // Parsed bodies are a slice of raw_request_ rather than a second copy;
+    // body_ is only used when the body is set by hand.
+    bool body_in_raw_ = false;
+    size_t body_offset_ = 0;
+    size_t body_length_ = 0;
 
-    // Helper methods
-    static std::string trim(const std::string& str);
-    static std::string to_lower(const std::string& str);
+    // True when the header block ended with "\r\n\r\n".
+    bool crlf_terminated_ = false;
+
+    std::map<std::string, std::string> query_params_;
 
     void parse_path_and_query();
 };
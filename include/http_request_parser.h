@@ -0,0 +1,152 @@
+#ifndef HTTP_REQUEST_PARSER_H
+#define HTTP_REQUEST_PARSER_H
+
+#include "http_request.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Resumable HTTP/1.1 request parser.
+//
+// Session feeds it every chunk read from the socket. Parsing picks up where
+// the previous chunk stopped, so each byte is scanned once no matter how many
+// reads a request takes. While parsing, the request line and headers are
+// kept as offsets into one owned buffer and exposed as string_view slices.
+// take_request() moves that buffer into the resulting HttpRequest as its raw
+// request when nothing follows the request, or copies just the request's bytes
+// when pipelined requests do. The body stays a slice of the raw request, but
+// the method, path, version and headers are copied into the request's own
+// strings and header map.
+//
+// Bodies sent with "Transfer-Encoding: chunked" are decoded as they arrive.
+// The framing is dropped from the buffer as soon as it is parsed, and the
+// decoded bytes collect in a separate string that Session can drain with
+// take_body_data() to stream them to a handler, so a long upload never has
+// to be held in memory as a whole.
+class HttpRequestParser {
+public:
+    // Strict mode is used on the wire: the body is delimited by
+    // Content-Length and structural errors are reported as soon as they are
+    // seen. Lenient mode backs HttpRequest::parse(), which treats everything
+    // after the headers as the body once finish() is called.
+    enum class Mode { Strict, Lenient };
+
+    enum class Result { NeedMore, Complete, Error };
+
+    enum class State { RequestLine, Headers, Body, Complete, Error };
+
+    enum class ErrorType {
+        None,
+        BadRequestLine,
+        HeaderTooLarge,
+        BadContentLength,
+        BadTransferEncoding,
+        UnsupportedTransferEncoding,
+        BadChunk,
+        BodyTooLarge
+    };
+
+    explicit HttpRequestParser(Mode mode = Mode::Strict);
+
+    // Append bytes and advance the state machine as far as they allow.
+    Result feed(const char* data, size_t length);
+    Result feed(std::string_view data) { return feed(data.data(), data.size()); }
+
+    // Signal end of input. Only meaningful in lenient mode, where it completes
+    // a request whose body runs to the end of the data.
+    Result finish();
+
+    // Move the completed request out of the parser. Bytes past the end of the
+    // request stay buffered and parsing restarts on them with the next feed().
+    HttpRequest take_request();
+
+    // Drop all buffered bytes and start over.
+    void reset();
+
+    State state() const { return state_; }
+    ErrorType error() const { return error_; }
+    std::string error_message() const;
+
+    // HTTP status code to answer an error with
+    int error_status_code() const;
+
+    // Slices of the request parsed so far (valid until the next feed()).
+    std::string_view method() const { return view(method_); }
+    std::string_view target() const { return view(target_); }
+    std::string_view version() const { return view(version_); }
+    std::vector<std::pair<std::string_view, std::string_view>> headers() const;
+
+    size_t content_length() const { return content_length_; }
+    size_t body_received() const;
+    size_t buffered_bytes() const { return buffer_.size() - base_; }
+
+    // True once the headers announced a chunked body
+    bool is_chunked() const { return chunked_; }
+
+    // Moves out the chunked body bytes decoded since the last call. Whatever
+    // is not taken ends up as the body of the request from take_request().
+    std::string take_body_data();
+
+    // Limit on the size of a body: its Content-Length, or the decoded bytes
+    // of a chunked one, whether or not they were drained with
+    // take_body_data(). 0 means no limit.
+    void set_max_body_bytes(size_t max_body_bytes) { max_body_bytes_ = max_body_bytes; }
+
+    static constexpr size_t kMaxHeaderBytes = 64 * 1024;
+    static constexpr size_t kDefaultMaxBodyBytes = 16 * 1024 * 1024;
+    static constexpr size_t kMaxChunkSizeLine = 1024;
+
+private:
+    struct Span {
+        size_t pos = 0;
+        size_t len = 0;
+    };
+
+    std::string_view view(const Span& span) const {
+        return std::string_view(buffer_).substr(span.pos, span.len);
+    }
+
+    Result advance();
+    void restart(size_t base);
+    void compact();
+    void parse_request_line(size_t line_end);
+    void parse_header_line(size_t line_end);
+    void finish_headers(size_t line_end);
+    void check_partial_request_line();
+    Result advance_chunked();
+    Result fail(ErrorType error);
+    Result result() const;
+
+    Mode mode_;
+    State state_ = State::RequestLine;
+    ErrorType error_ = ErrorType::None;
+
+    std::string buffer_;
+    size_t base_ = 0;          // start of the current request; earlier bytes were taken
+    size_t scan_pos_ = 0;      // next byte the state machine will look at
+    size_t line_start_ = 0;    // start of the line currently being parsed
+
+    Span method_;
+    Span target_;
+    Span version_;
+    std::vector<std::pair<Span, Span>> headers_;
+    bool crlf_terminated_ = false;
+
+    size_t body_start_ = 0;
+    size_t content_length_ = 0;
+    size_t consumed_ = 0;      // total bytes belonging to the completed request
+    size_t max_body_bytes_ = kDefaultMaxBodyBytes;
+
+    // Chunked decoding; scan_pos_ tracks the framing after body_start_
+    enum class ChunkState { Size, Data, DataEnd, Trailers };
+    bool chunked_ = false;
+    ChunkState chunk_state_ = ChunkState::Size;
+    size_t chunk_remaining_ = 0;
+    size_t chunked_received_ = 0;  // decoded bytes so far, drained or not
+    size_t trailer_bytes_ = 0;
+    std::string chunked_body_;
+};
+
+#endif
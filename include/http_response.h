@@ -3,6 +3,10 @@
 
 #include <string>
 #include <map>
+#include <memory>
+#include <vector>
+#include <boost/asio/buffer.hpp>
+#include "response_body.h"
 
 class HttpResponse
 {
@@ -13,8 +17,9 @@ public:
   HttpResponse();
 
   // Non-default constructor
+  // The body is taken by value so callers can move large bodies in
   HttpResponse(const std::string& v, int sc, const std::string& rp, 
-                const std::map<std::string, std::string>& hm, const std::string& mb);
+                const std::map<std::string, std::string>& hm, std::string mb);
 
   // Setters
   void set_version(const std::string& v);
@@ -23,8 +28,24 @@ public:
 
   void set_header(const std::string& k, const std::string& v);
 
-  void set_message_body(const std::string& mb);
+  void remove_header(const std::string& k);
 
+  void set_message_body(std::string mb);
+
+  // Streams the body instead of holding it in message_body. Sets
+  // Content-Length when the stream knows its size, Transfer-Encoding:
+  // chunked otherwise.
+  void set_body_stream(std::shared_ptr<ResponseBody> body);
+
+
+  // Makes this a response serialized ahead of time, e.g. by a cache: head
+  // holds the status line and headers (ending with the blank line) and body
+  // follows it. Both are shared, not copied, and written as they are. The
+  // setters above still work; the first one unpacks head into headers.
+  void set_prepared(int sc, std::shared_ptr<const std::string> head,
+                    std::shared_ptr<const std::string> body);
+
+  bool is_prepared() const { return prepared_head != nullptr; }
 
   // Getters
   std::string get_version() const;
@@ -33,11 +54,24 @@ public:
 
   std::string get_header(const std::string& header_name) const;
 
-  std::string get_message_body() const;
+  const std::string& get_message_body() const;
+
+  // Null unless the body is streamed
+  const std::shared_ptr<ResponseBody>& get_body_stream() const;
 
   // Methods
+  // Head plus message_body; a streamed body is not included
   std::string convert_to_string() const;
 
+  // Status line and header lines, including the blank line that ends them
+  std::string serialize_head() const;
+
+  // Buffer sequence for a gathered write: the given head followed by the
+  // body, which is referenced rather than copied. Both the head string and
+  // this response must outlive the write. A prepared response uses its own
+  // head and ignores the given one.
+  std::vector<boost::asio::const_buffer> to_buffers(const std::string& head) const;
+
 private:
 
   // Status line components
@@ -51,6 +85,14 @@ private:
   
   // Message body components
   std::string message_body;
+  std::shared_ptr<ResponseBody> body_stream;
+
+  // Set by set_prepared(); the fields above then only hold status_code
+  std::shared_ptr<const std::string> prepared_head;
+  std::shared_ptr<const std::string> prepared_body;
+
+  // Turns a prepared response back into an ordinary one
+  void unprepare();
 
 };
 
@@ -0,0 +1,73 @@
+#ifndef ID_ALLOCATOR_H
+#define ID_ALLOCATOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+// Hands out numeric IDs for one entity type without looking at the IDs in
+// use. The store reports every ID it writes (claim) or deletes (release),
+// so the allocator always knows the highest one.
+//
+// Without reuse an allocation is one atomic increment and IDs are never
+// handed out twice, even after a delete. With reuse, released IDs and IDs
+// skipped over by claims are kept as ranges and the smallest is handed out
+// first, so the result is the smallest positive ID not in use, at the cost
+// of a lock and O(log ranges) per call.
+//
+// IDs that are not positive decimal numbers are ignored.
+class IdAllocator {
+public:
+    explicit IdAllocator(bool reuse) : reuse_(reuse) {}
+
+    IdAllocator(const IdAllocator&) = delete;
+    IdAllocator& operator=(const IdAllocator&) = delete;
+
+    // Reserves and returns a new ID. Throws std::overflow_error once IDs
+    // would no longer fit in an int.
+    std::string allocate();
+
+    // id is in use
+    void claim(const std::string& id);
+
+    // id is no longer in use
+    void release(const std::string& id);
+
+    static std::optional<uint64_t> parse(const std::string& id);
+
+    static constexpr uint64_t kMaxId = 2147483647;  // INT_MAX, as IDs always were
+
+private:
+    void claim_locked(uint64_t id);
+
+    const bool reuse_;
+    // Every ID at or above next_ is free
+    std::atomic<uint64_t> next_{1};
+
+    // With reuse only: free IDs below next_, as first -> last of each range
+    std::mutex mutex_;
+    std::map<uint64_t, uint64_t> free_;
+};
+
+// One IdAllocator per entity type, created on first use
+class IdAllocators {
+public:
+    explicit IdAllocators(bool reuse) : reuse_(reuse) {}
+
+    IdAllocator& get(const std::string& entity);
+
+    void clear();
+
+private:
+    const bool reuse_;
+    std::shared_mutex mutex_;
+    std::unordered_map<std::string, std::unique_ptr<IdAllocator>> allocators_;
+};
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef LOG_STRUCTURED_FILESYSTEM_H
+#define LOG_STRUCTURED_FILESYSTEM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "filesystem_interface.h"
+#include "id_allocator.h"
+
+// Durable CRUD storage in append-only segment files under a root directory.
+//
+// Every write and delete is appended as one checksummed record to the
+// newest segment (segment-000001.log, segment-000002.log, ...), and a new
+// segment is started once it reaches segment_bytes. Deletes are tombstone
+// records. An in-memory index maps (entity, id) to where the latest value
+// is, so a read is a single pread() and existence checks and listings never
+// touch the disk.
+//
+// On startup the segments are replayed to rebuild the index. In the newest
+// segment, a record that is cut short or fails its checksum (a crash in the
+// middle of an append) ends the segment, which is truncated there. The same
+// in an older, sealed segment is corruption, and the constructor throws
+// rather than drop records after it.
+//
+// New IDs come from an IdAllocator per entity type. The replay tells it
+// every ID ever written, so an ID is not handed out again after a restart
+// either, unless reuse_ids is set.
+//
+// Only one instance may use a root at a time.
+class LogStructuredFilesystem : public FilesystemInterface {
+public:
+    struct Options {
+        size_t segment_bytes = 64 * 1024 * 1024;
+        // fdatasync() after every append, so a write that succeeded also
+        // survives a power failure and not only a crash of the server
+        bool sync = false;
+        // Hand out deleted IDs again, smallest first, like MockFilesystem
+        bool reuse_ids = false;
+    };
+
+    // Throws std::runtime_error if root cannot be created or its segments
+    // cannot be opened
+    explicit LogStructuredFilesystem(const std::string& root);
+    LogStructuredFilesystem(const std::string& root, Options options);
+    ~LogStructuredFilesystem() override;
+
+    LogStructuredFilesystem(const LogStructuredFilesystem&) = delete;
+    LogStructuredFilesystem& operator=(const LogStructuredFilesystem&) = delete;
+
+    bool entity_exists(const Entity& entity, const std::string& id) const override;
+    bool write_entity(const Entity& entity, const std::string& id, const std::string& data) override;
+    std::string read_entity(const Entity& entity, const std::string& id) const override;
+    bool delete_entity(const Entity& entity, const std::string& id) override;
+
+    std::vector<std::string> list_entity_ids(const Entity& entity) const override;
+    std::string next_entity_id(const Entity& entity) const override;
+
+    const std::string& root() const { return root_; }
+    size_t segments() const;
+
+    // Bytes of records that were overwritten or deleted since (for
+    // tests/metrics)
+    uint64_t dead_bytes() const;
+
+private:
+    enum RecordType : uint8_t { kPut = 1, kDelete = 2 };
+
+    // Where the current value of one id is
+    struct Location {
+        size_t segment;
+        uint64_t offset;       // of the value
+        uint32_t length;       // of the value
+        uint64_t record_size;  // header, names and value
+    };
+
+    struct Segment {
+        uint64_t number;  // in the file name
+        int fd;
+        uint64_t size;
+    };
+
+    using IdIndex = std::unordered_map<std::string, Location>;
+
+    void open_segments();
+    void open_segment(uint64_t number, bool create);
+    void replay(size_t segment, bool last);
+
+    // Applies a record to the index and the ID allocators; caller holds
+    // mutex_ exclusively
+    void apply(RecordType type, const std::string& entity, const std::string& id, const Location& location);
+
+    // Appends one record to the newest segment; caller holds mutex_
+    // exclusively. False, with nothing written, on failure.
+    bool append(RecordType type, const std::string& entity, const std::string& id,
+                const std::string& value, Location& location);
+
+    std::string segment_path(uint64_t number) const;
+
+    const std::string root_;
+    const Options options_;
+
+    // Guards everything below. Reads hold it shared only to find the value;
+    // segment descriptors stay open until destruction, so the pread()
+    // itself happens without it.
+    mutable std::shared_mutex mutex_;
+    std::vector<Segment> segments_;
+    // index_[entity.name][id]
+    std::unordered_map<std::string, IdIndex> index_;
+    uint64_t dead_bytes_ = 0;
+
+    // Allocation itself only takes the allocator's own lock
+    mutable IdAllocators ids_;
+};
+
+#endif
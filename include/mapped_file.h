@@ -0,0 +1,72 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// A whole file mapped read-only into memory. The mapping is removed when the
+// last reference goes away, so responses holding one can keep sending from
+// it after the file has been replaced on disk.
+//
+// Replacing a file by renaming a new one over it is safe. Truncating a file
+// in place while it is mapped makes reads past its new end fault (SIGBUS).
+class MappedFile {
+public:
+    // Throws std::runtime_error if the file cannot be opened or mapped
+    static std::shared_ptr<const MappedFile> map(const std::string& path);
+
+    // Maps an open file; fd stays the caller's. name is only for errors.
+    static std::shared_ptr<const MappedFile> map(int fd, const std::string& name);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+    // What the file looked like when it was mapped
+    uint64_t inode() const { return inode_; }
+    int64_t mtime_ns() const { return mtime_ns_; }
+
+private:
+    MappedFile() = default;
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    uint64_t inode_ = 0;
+    int64_t mtime_ns_ = 0;
+};
+
+// Hands out one shared mapping per file to every request serving it.
+//
+// The cache only holds weak references: a mapping lives as long as some
+// response is using it, and is remapped when the file is requested again
+// with a different inode, size or mtime.
+class MappingCache {
+public:
+    // The mapping of path if it still matches the given identity (from a
+    // stat the caller just did), otherwise a fresh one. Throws
+    // std::runtime_error like MappedFile::map().
+    std::shared_ptr<const MappedFile> acquire(const std::string& path, uint64_t inode,
+                                              uint64_t size, int64_t mtime_ns);
+
+    // Same, but a fresh mapping is made from fd, which the caller opened
+    // as path and keeps
+    std::shared_ptr<const MappedFile> acquire(const std::string& path, int fd, uint64_t inode,
+                                              uint64_t size, int64_t mtime_ns);
+
+    // Files with a live mapping (for tests/metrics)
+    size_t mapped_files() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::weak_ptr<const MappedFile>> mappings_;
+};
+
+#endif
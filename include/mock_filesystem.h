@@ -1,17 +1,31 @@
 #ifndef MOCK_FILESYSTEM_H
 #define MOCK_FILESYSTEM_H
 
+#include <array>
+#include <cstddef>
+#include <shared_mutex>
 #include <unordered_map>
 #include <string>
 #include <vector>
 
 #include "filesystem_interface.h"
+#include "id_allocator.h"
 
 // This implementation does NOT touch the real filesystem; it's intended
-// for unit-testing the CRUD handler via dependency injection.
+// for unit-testing the CRUD handler via dependency injection, and backs
+// CrudHandler locations that have no root.
+//
+// It is safe to share between threads. Entities are spread over kShards
+// shards by (entity, id), each with its own reader/writer lock, so
+// requests for different entities rarely wait for each other and reads
+// never wait for reads.
+//
+// next_entity_id() reserves the ID it returns, so concurrent POSTs never
+// get the same one. By default it is the smallest positive ID not in use;
+// without reuse_ids, deleted IDs are never handed out again.
 class MockFilesystem : public FilesystemInterface {
 public:
-    MockFilesystem() = default;
+    explicit MockFilesystem(bool reuse_ids = true) : ids_(reuse_ids) {}
     ~MockFilesystem() override = default;
 
     bool entity_exists(const Entity& entity, const std::string& id) const override;
@@ -19,15 +33,32 @@ public:
     std::string read_entity(const Entity& entity, const std::string& id) const override;
     bool delete_entity(const Entity& entity, const std::string& id) override;
 
+    // Visits the shards one after another, so entities written or deleted
+    // meanwhile may or may not be included
     std::vector<std::string> list_entity_ids(const Entity& entity) const override;
     std::string next_entity_id(const Entity& entity) const override;
 
-    // For tests to reset state if needed
+    // For tests to reset state if needed; not while other calls run
     void reset();
 
+    static constexpr size_t kShards = 16;
+
 private:
-    // data_[entity.name][id] = JSON payload
-    std::unordered_map<std::string, std::unordered_map<std::string, std::string>> data_;
+    // On its own cache line, so threads locking neighbouring shards do not
+    // contend for it
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        // data[entity.name][id] = JSON payload
+        std::unordered_map<std::string, std::unordered_map<std::string, std::string>> data;
+    };
+
+    Shard& shard_for(const Entity& entity, const std::string& id) const;
+
+    mutable std::array<Shard, kShards> shards_;
+
+    // Updated under the shard lock of the ID, so a write and a delete of
+    // the same ID reach the allocator in the order they happened
+    mutable IdAllocators ids_;
 };
 
 #endif
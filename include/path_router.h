@@ -6,21 +6,28 @@
 #include "file_handler.h"
 #include "server_config.h"
 #include "handler_factory.h"
+#include "route_trie.h"
 #include <memory>
 #include <string>
 
 // path_router.h
+//
+// Every location's handler is built and validated once, when the router is
+// constructed, and the same instance then serves all requests on all threads
+// (see the contract in request_handler.h). Lookups go through a RouteTrie,
+// so they cost the length of the path rather than the number of locations.
 class PathRouter {
 public:
     PathRouter(const ServerConfig& config);
-    std::unique_ptr<RequestHandler> match_handler(const std::string& path) const;
+    std::shared_ptr<RequestHandler> match_handler(const std::string& path) const;
     
 private:
-    std::map<std::string, HandlerConfig> routes_;
+    RouteTrie routes_;
+    std::shared_ptr<RequestHandler> not_found_handler_;
 
     // Handler Factory
     HandlerFactory handler_factory_;
     
 };
 
-#endif
\ No newline at end of file
+#endif
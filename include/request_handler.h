@@ -3,9 +3,30 @@
 
 #include "http_request.h"
 #include "http_response.h"
+#include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_set>
 
+// One request's chunked body, handed over piece by piece as it is decoded.
+// A handler creates one per request in begin_body(), so whatever it keeps
+// belongs to that request alone.
+class BodySink {
+
+  public:
+    virtual ~BodySink() = default;
+
+    // Called on the network thread for each decoded piece, so it must not block
+    virtual void write(std::string_view data) = 0;
+
+};
+
+// One handler instance is built per location when the PathRouter is created
+// and shared by every session on every thread. Its methods may therefore run
+// concurrently: handlers must only read their configuration after
+// construction, and any state they mutate (a store, a cache) must do its own
+// locking. Per-request state belongs in a BodySink. Configuration setters
+// such as set_blocking() are for the factory only.
 class RequestHandler {
 
   public:
@@ -15,6 +36,30 @@ class RequestHandler {
 
     virtual std::string get_handler_name() const = 0;
 
+    // Blocking handlers are run on the BlockingExecutor instead of the
+    // network threads. Handlers that sleep or do synchronous disk I/O mark
+    // themselves blocking; a location can override it with "blocking on|off;".
+    bool is_blocking() const { return blocking_; }
+
+    void set_blocking(bool blocking) { blocking_ = blocking; }
+
+    // Called on the network thread once the headers of a chunked request are
+    // in; head has the method, path and headers but no body. A handler that
+    // wants the body as it arrives returns a sink, and Session writes each
+    // decoded piece to it instead of buffering the body. Returning null
+    // keeps the buffered body and handle_request().
+    virtual std::unique_ptr<BodySink> begin_body(const HttpRequest& head) { return nullptr; }
+
+    // Called instead of handle_request() for a request whose body went to a
+    // sink, once all of it has. The request has an empty body, and body is
+    // the sink this handler's begin_body() returned for it.
+    virtual HttpResponse handle_streamed_request(const HttpRequest& request, BodySink& body) {
+      return handle_request(request);
+    }
+
+  protected:
+    bool blocking_ = false;
+
 };
 
 #endif
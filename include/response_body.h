@@ -0,0 +1,145 @@
+#ifndef RESPONSE_BODY_H
+#define RESPONSE_BODY_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class MappedFile;
+
+// A response body produced piece by piece instead of held in one string.
+//
+// A handler attaches one to its HttpResponse with set_body_stream(). Session
+// writes the head first and then pulls the body with read(), one buffer at
+// a time, only after the previous piece has gone out to the socket, so a slow
+// client holds back the producer instead of making the server buffer.
+// Bodies whose size is not known up front are sent with chunked encoding.
+class ResponseBody {
+public:
+    virtual ~ResponseBody() = default;
+
+    // Total length in bytes, if known before the first read
+    virtual std::optional<size_t> size() const = 0;
+
+    // Copies up to capacity bytes into data and returns how many were
+    // written; 0 means the body is complete. Throws std::runtime_error if
+    // the body cannot be produced, in which case the connection is closed.
+    virtual size_t read(char* data, size_t capacity) = 0;
+};
+
+// A byte range of a file, read with pread() as the client drains it. Session
+// skips read() for these and has the kernel copy the range straight from the
+// page cache to the socket with send_to().
+class FileBody : public ResponseBody {
+public:
+    // Throws std::runtime_error if the file cannot be opened
+    FileBody(const std::string& path, size_t offset, size_t length);
+
+    // Takes ownership of an open descriptor; throws std::runtime_error if
+    // fd is negative (e.g. a failed dup())
+    FileBody(int fd, size_t offset, size_t length);
+    ~FileBody() override;
+
+    FileBody(const FileBody&) = delete;
+    FileBody& operator=(const FileBody&) = delete;
+
+    std::optional<size_t> size() const override { return length_; }
+    size_t read(char* data, size_t capacity) override;
+
+    // Sends up to max_bytes of the rest of the range to a socket with
+    // sendfile(2) and returns how many went out; 0 once the range is done.
+    // Sets would_block instead when a non-blocking socket is full. Throws
+    // std::runtime_error like read().
+    size_t send_to(int socket_fd, size_t max_bytes, bool& would_block);
+
+    size_t remaining() const { return length_ - position_; }
+
+    // For reading the range elsewhere (see FileReader): the descriptor, the
+    // file offset the next read starts at, and a way to record that n more
+    // bytes were read
+    int fd() const { return fd_; }
+    uint64_t next_offset() const { return offset_ + position_; }
+    void consume(size_t n) { position_ += std::min(n, remaining()); }
+
+private:
+    int fd_ = -1;
+    size_t offset_;
+    size_t length_;
+    size_t position_ = 0;  // bytes already read, relative to offset_
+};
+
+// A byte range of a memory-mapped file. Session writes it to the socket
+// straight from the mapped pages with next_span(); read() copies, for use
+// inside a CompositeBody.
+class MappedBody : public ResponseBody {
+public:
+    // Throws std::runtime_error if the range lies outside the mapping
+    MappedBody(std::shared_ptr<const MappedFile> file, size_t offset, size_t length);
+
+    std::optional<size_t> size() const override { return length_; }
+    size_t read(char* data, size_t capacity) override;
+
+    // The next up to max_bytes of the range, which stay valid as long as
+    // this body does; empty once the range is done
+    std::string_view next_span(size_t max_bytes);
+
+private:
+    std::shared_ptr<const MappedFile> file_;
+    size_t offset_;
+    size_t length_;
+    size_t position_ = 0;
+};
+
+// A body of unknown length made by a callback; each call returns the next
+// piece, or std::nullopt when there is nothing more to send.
+class GeneratorBody : public ResponseBody {
+public:
+    using Generator = std::function<std::optional<std::string>()>;
+
+    explicit GeneratorBody(Generator generator);
+
+    std::optional<size_t> size() const override { return std::nullopt; }
+    size_t read(char* data, size_t capacity) override;
+
+private:
+    Generator generator_;
+    std::string pending_;     // part of the last piece that did not fit
+    size_t pending_pos_ = 0;
+    bool done_ = false;
+};
+
+// A body already held in memory, e.g. the part headers of a multipart
+// response
+class StringBody : public ResponseBody {
+public:
+    explicit StringBody(std::string data);
+
+    std::optional<size_t> size() const override { return data_.size(); }
+    size_t read(char* data, size_t capacity) override;
+
+private:
+    std::string data_;
+    size_t position_ = 0;
+};
+
+// Several bodies sent back to back, such as the parts of a
+// multipart/byteranges response. Its size is known if every part's is.
+class CompositeBody : public ResponseBody {
+public:
+    void append(std::shared_ptr<ResponseBody> part);
+
+    std::optional<size_t> size() const override;
+    size_t read(char* data, size_t capacity) override;
+
+private:
+    std::vector<std::shared_ptr<ResponseBody>> parts_;
+    size_t current_ = 0;
+};
+
+#endif
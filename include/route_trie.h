@@ -0,0 +1,44 @@
+#ifndef ROUTE_TRIE_H
+#define ROUTE_TRIE_H
+
+#include "request_handler.h"
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Compressed radix trie from location prefixes to their handlers.
+//
+// Edges carry whole runs of characters, so a lookup compares each byte of
+// the path at most once no matter how many locations there are. A location
+// only matches on a path-segment boundary: "/api" matches "/api" and
+// "/api/v1" but not "/apiary". Trailing slashes are ignored on insert, so
+// "/" is the empty prefix and matches every path starting with '/'.
+class RouteTrie {
+public:
+    RouteTrie();
+
+    // Adds or replaces the handler for a location prefix
+    void insert(std::string_view prefix, std::shared_ptr<RequestHandler> handler);
+
+    // Handler of the longest location matching path, or nullptr. Anything
+    // from a '?' or '#' on is not part of the path and is ignored.
+    std::shared_ptr<RequestHandler> match(std::string_view path) const;
+
+    size_t size() const { return size_; }
+
+private:
+    struct Node {
+        std::string label;
+        std::shared_ptr<RequestHandler> handler;
+        // Sorted by the first byte of their label, which is unique per child
+        std::vector<std::unique_ptr<Node>> children;
+    };
+
+    static const Node* find_child(const Node& node, char c);
+
+    std::unique_ptr<Node> root_;
+    size_t size_ = 0;
+};
+
+#endif
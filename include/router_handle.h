@@ -0,0 +1,40 @@
+#ifndef ROUTER_HANDLE_H
+#define ROUTER_HANDLE_H
+
+#include "path_router.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+// The currently published PathRouter, swappable at runtime (config reload).
+//
+// Readers go through current(), which returns the router this thread last
+// saw as long as the generation counter has not moved, so the request path
+// costs one atomic load and no lock. After a publish() each thread takes the
+// lock once to pick up the new router. A replaced router is freed when the
+// last request, session or thread cache holding it lets go, so requests
+// already running finish with the handlers they started with.
+class RouterHandle {
+public:
+    explicit RouterHandle(std::shared_ptr<const PathRouter> router);
+
+    std::shared_ptr<const PathRouter> current() const;
+
+    // Makes router the one returned by current() from now on
+    void publish(std::shared_ptr<const PathRouter> router);
+
+    // Incremented by every publish()
+    uint64_t generation() const { return generation_.load(std::memory_order_acquire); }
+
+private:
+    // Distinguishes handles in the per-thread cache, even at a reused address
+    const uint64_t id_;
+    std::atomic<uint64_t> generation_{0};
+
+    // Guards router_; only taken by publish() and on a cache miss
+    mutable std::mutex mutex_;
+    std::shared_ptr<const PathRouter> router_;
+};
+
+#endif
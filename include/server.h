@@ -2,7 +2,10 @@
 #define SERVER_H
 
 #include "session.h"
-#include "path_router.h"
+#include "router_handle.h"
+#include "buffer_pool.h"
+#include "blocking_executor.h"
+#include "timer_wheel.h"
 #include <boost/asio.hpp>
 #include <memory>
 
@@ -11,8 +14,15 @@ using boost::asio::ip::tcp;
 class Server
 {
 public:
+  // With reuse_port the acceptor is bound with SO_REUSEPORT, so several
+  // servers (one per io_service) can listen on the same port and the kernel
+  // spreads incoming connections across them.
   Server(boost::asio::io_service& io_service, short port,
-         std::shared_ptr<PathRouter> router);
+         std::shared_ptr<RouterHandle> router,
+         std::shared_ptr<BufferPool> buffer_pool,
+         std::shared_ptr<BlockingExecutor> executor = nullptr,
+         bool reuse_port = false,
+         const SessionOptions& options = SessionOptions());
 
 private:
   void start_accept();
@@ -23,7 +33,13 @@ private:
   boost::asio::io_service& io_service_;
   tcp::acceptor acceptor_;
 
-  std::shared_ptr<PathRouter> router_;
+  std::shared_ptr<RouterHandle> router_;
+  std::shared_ptr<BufferPool> buffer_pool_;
+  std::shared_ptr<BlockingExecutor> executor_;
+
+  // One wheel for all sessions on this io_service
+  std::shared_ptr<TimerWheel> timer_wheel_;
+  SessionOptions options_;
 };
 
 #endif
\ No newline at end of file
@@ -11,6 +11,18 @@ struct HandlerConfig {
     std::map<std::string, std::string> settings;  // Handler-specific settings
 };
 
+// How worker threads share the network reactor
+enum class ThreadMode {
+    Shared,   // one io_service run by every worker thread (default)
+    PerCore   // one io_service and SO_REUSEPORT acceptor per core
+};
+
+// How streamed file bodies get from disk to the socket
+enum class FileIo {
+    Sendfile,  // sendfile(2) on the I/O thread, zero-copy (default)
+    Async      // read through a FileReader (io_uring or threads), then written
+};
+
 class ServerConfig {
 public:
     ServerConfig() = default;
@@ -21,9 +33,27 @@ public:
     // Getters
     int get_port() const { return port_; }
     const std::map<std::string, HandlerConfig>& get_routes() const { return routes_; }
+    ThreadMode get_thread_mode() const { return thread_mode_; }
+    int get_blocking_threads() const { return blocking_threads_; }
+    int get_idle_timeout() const { return idle_timeout_; }
+    int get_header_timeout() const { return header_timeout_; }
+    int get_body_timeout() const { return body_timeout_; }
+    size_t get_max_body_size() const { return max_body_size_; }
+    FileIo get_file_io() const { return file_io_; }
     
 private:
     int port_ = 8080;
+    ThreadMode thread_mode_ = ThreadMode::Shared;
+    int blocking_threads_ = 16;  // workers for blocking handlers
+
+    // Connection timeouts in seconds, 0 disables
+    int idle_timeout_ = 60;
+    int header_timeout_ = 10;
+    int body_timeout_ = 30;
+
+    // Largest request body buffered in memory, in bytes, 0 for no limit
+    size_t max_body_size_ = 16 * 1024 * 1024;
+    FileIo file_io_ = FileIo::Sendfile;
     std::map<std::string, HandlerConfig> routes_;  // path -> handler config
     
     // Helper to parse handler config from nginx block
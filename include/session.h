@@ -3,35 +3,162 @@
 
 #include <boost/asio.hpp>
 #include <boost/enable_shared_from_this.hpp>
-#include "path_router.h"
+#include "router_handle.h"
+#include "http_request_parser.h"
+#include "buffer_pool.h"
+#include "blocking_executor.h"
+#include "file_reader.h"
+#include "timer_wheel.h"
+#include <chrono>
 #include <string>
 #include <memory>
+#include <deque>
 
 using boost::asio::ip::tcp;
 
-class Session : public std::enable_shared_from_this<Session>
+// Per-connection limits; zero disables one
+struct SessionOptions {
+  // No request in progress (keep-alive), or a response not being drained
+  std::chrono::seconds idle_timeout{60};
+  // From the first byte of a request until its headers are complete
+  std::chrono::seconds header_timeout{10};
+  // Longest gap between reads of a request body
+  std::chrono::seconds body_timeout{30};
+  // Largest request body, buffered or streamed (see HttpRequestParser)
+  size_t max_body_bytes = HttpRequestParser::kDefaultMaxBodyBytes;
+  // Reads streamed file bodies off the I/O thread when set ("file_io
+  // async"); otherwise they go out with sendfile(2)
+  std::shared_ptr<FileReader> file_reader;
+};
+
+class Session : public std::enable_shared_from_this<Session>,
+                public TimerWheel::Client
 {
 public:
   Session(boost::asio::io_service& io_service,
-          std::shared_ptr<PathRouter> router);
+          std::shared_ptr<RouterHandle> router,
+          std::shared_ptr<BufferPool> buffer_pool,
+          std::shared_ptr<BlockingExecutor> executor = nullptr,
+          std::shared_ptr<TimerWheel> timer_wheel = nullptr,
+          const SessionOptions& options = SessionOptions());
 
   tcp::socket& socket();
 
   void start();
 
+  // Called by the timer wheel; closes the connection on the session's strand
+  void on_timeout() override;
+
 private:
+  void do_read();
+
+  void handle_readable(const boost::system::error_code& error);
+
+  size_t next_read_size() const;
+
   void handle_read(const boost::system::error_code& error,
       size_t bytes_transferred);
 
-  void handle_write(const boost::system::error_code& error);
+  void start_write();
+
+  void handle_write(const boost::system::error_code& error, size_t count);
+
+  void write_body_piece();
+
+  void send_file_piece(FileBody& file);
+  void send_mapped_piece(MappedBody& mapped);
+  void read_file_piece(FileBody& file);
+  void handle_file_read(ssize_t result);
+
+  void handle_body_write(const boost::system::error_code& error, bool last);
+
+  void finish_body();
+
+  void continue_writing();
+
+  void close_after_response();
+
+  void discard_input();
+
+  void process_buffered_requests();
+
+  void update_read_deadline();
+
+  void handle_timeout();
+
+  void stream_body_data();
+
+  bool handle_request(HttpRequest request,
+      std::shared_ptr<RequestHandler> handler = nullptr,
+      std::unique_ptr<BodySink> body = nullptr);
+
+  bool dispatch_blocking(std::shared_ptr<RequestHandler> handler,
+      std::shared_ptr<HttpRequest> request, std::shared_ptr<BodySink> body);
+
+  void finish_blocking_request(HttpResponse response, const std::string& path,
+      const std::string& handler_name);
+
+  void queue_response(HttpResponse response, const std::string& path,
+      const std::string& handler_name);
 
   tcp::socket socket_;
-  enum { max_length = 1024 };
-  char data_[max_length];
 
-  std::string buffer_;
+  // Declared before read_buffer_ so the pool outlives the buffer it hands out
+  std::shared_ptr<BufferPool> buffer_pool_;
+
+  // Only held while a read is outstanding or a request is partially received;
+  // idle keep-alive connections give it back to the pool.
+  BufferPool::Buffer read_buffer_;
+
+  // Preferred read size, adapted to how much each read actually returns
+  size_t read_hint_ = BufferPool::kMinBufferSize;
+
+  HttpRequestParser parser_;
+
+  // Sink receiving the current chunked body as it arrives, if its handler
+  // gave one, and that handler
+  std::shared_ptr<RequestHandler> body_handler_;
+  std::unique_ptr<BodySink> body_sink_;
+  bool body_handler_checked_ = false;
+
+  // A response waiting to be written, with its serialized head
+  struct OutgoingResponse {
+    std::string head;
+    HttpResponse response;
+  };
+
+  // Responses for every request handled since the last write. A deque so
+  // queued entries never move while their buffers are referenced.
+  std::deque<OutgoingResponse> write_queue_;
+
+  // Set once a response that ends the connection is queued; nothing more is
+  // read as requests, and the socket is shut down after the queue drains
+  bool closing_ = false;
+  size_t discarded_bytes_ = 0;
+
+  // Streamed body being written, and the pooled buffer its pieces go through
+  std::shared_ptr<ResponseBody> body_stream_;
+  bool body_chunked_ = false;
+  BufferPool::Buffer body_buffer_;
+
+  // Consulted per request, so a reloaded config applies from the next one
+  std::shared_ptr<RouterHandle> router_;
+
+  // Runs blocking handlers off the network threads; may be null, in which
+  // case every handler runs inline
+  std::shared_ptr<BlockingExecutor> executor_;
+
+  // Every completion handler of the session runs here, so the executor's
+  // responses and the timer wheel never race the network handlers
+  boost::asio::strand<boost::asio::io_service::executor_type> strand_;
+
+  enum class TimeoutPhase { Idle, Header, Body };
+
+  void set_timeout(TimeoutPhase phase, std::chrono::seconds timeout);
 
-  std::shared_ptr<PathRouter> router_;
+  std::shared_ptr<TimerWheel> timer_wheel_;
+  SessionOptions options_;
+  TimeoutPhase timeout_phase_ = TimeoutPhase::Idle;
 };
 
 #endif
\ No newline at end of file
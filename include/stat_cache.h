@@ -0,0 +1,105 @@
+#ifndef STAT_CACHE_H
+#define STAT_CACHE_H
+
+#include "directory_watcher.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+
+// Remembers stat() results so FileHandler can resolve paths, including ones
+// that do not exist, without a system call per request.
+//
+// Up to max_entries results are kept, least recently used evicted first.
+// The directory of every result is watched with inotify (through a
+// DirectoryWatcher shared with the other caches), or for a missing
+// path the nearest ancestor that exists, and a change to a name drops what
+// is known about it and everything below it. Files that were found are
+// re-checked after ttl regardless, as are missing paths no directory could
+// be watched for; other missing paths stay cached until something changes.
+class StatCache {
+public:
+    struct Result {
+        bool exists = false;   // stat() succeeded
+        bool regular = false;  // and found a regular file
+        uint64_t inode = 0;
+        uint64_t size = 0;
+        int64_t mtime_ns = 0;
+    };
+
+    static constexpr std::chrono::milliseconds kDefaultTtl{1000};
+
+    // Looks path up on a miss; stat_uncached() unless given
+    using Lookup = std::function<Result(const std::string& path)>;
+
+    explicit StatCache(size_t max_entries, std::chrono::milliseconds ttl = kDefaultTtl,
+                       Lookup lookup = nullptr,
+                       std::shared_ptr<DirectoryWatcher> watcher = DirectoryWatcher::shared());
+
+    // Unsubscribes from the watcher, dropping the watches only this cache used
+    ~StatCache();
+
+    StatCache(const StatCache&) = delete;
+    StatCache& operator=(const StatCache&) = delete;
+
+    // Lookup of path, answered from the cache while the entry is fresh
+    Result stat(const std::string& path);
+
+    // stat() without a cache
+    static Result stat_uncached(const std::string& path);
+
+    // fstat() of an open file
+    static Result stat_fd(int fd);
+
+    // Forgets path and everything below it
+    void invalidate(const std::string& path);
+
+    void clear();
+
+    bool watching() const { return watcher_->active(); }
+    size_t entries() const;
+    size_t max_entries() const { return max_entries_; }
+    std::chrono::milliseconds ttl() const { return ttl_; }
+
+    // Lookups answered without a stat() (for tests/metrics)
+    uint64_t hits() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    using LruList = std::list<std::string>;
+
+    struct Slot {
+        Result result;
+        Clock::time_point expires;
+        LruList::iterator lru;
+    };
+
+    // Watches the directory an event for path would show up in; false if
+    // there is none to watch
+    bool watch_for(const std::string& path, bool exists);
+
+    void invalidate_locked(const std::string& path);
+
+    const size_t max_entries_;
+    const std::chrono::milliseconds ttl_;
+    const Lookup lookup_;
+
+    mutable std::mutex mutex_;
+    // Ordered, so everything below a directory is one range
+    std::map<std::string, Slot> entries_;
+    LruList lru_;  // most recently used first
+    uint64_t hits_ = 0;
+
+    // Bumped by every invalidation, so a stat() that raced with one is not
+    // cached
+    uint64_t generation_ = 0;
+
+    std::shared_ptr<DirectoryWatcher> watcher_;
+    DirectoryWatcher::Subscription subscription_ = 0;
+};
+
+#endif
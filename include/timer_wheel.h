@@ -0,0 +1,90 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Hashed timer wheel for connection timeouts.
+//
+// One wheel serves every connection on an io_service, driven by a single
+// steady_timer that ticks every tick_duration. Clients keep one deadline
+// each; moving it later does not touch the wheel, the entry just gets
+// re-slotted when its original slot comes up. Only moving a deadline earlier
+// than its current slot inserts a new entry. That keeps per-connection cost
+// to a couple of words and an occasional vector push.
+//
+// Entries hold weak_ptrs, so a client that goes away is simply skipped.
+class TimerWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::chrono::milliseconds kDefaultTick{250};
+    static constexpr size_t kDefaultSlots = 1024;
+
+    class Client {
+    public:
+        virtual ~Client() = default;
+
+        // Called from the wheel's timer, without the wheel lock held, once
+        // the deadline has passed. Must not block.
+        virtual void on_timeout() = 0;
+
+    private:
+        friend class TimerWheel;
+        Clock::time_point deadline_ = Clock::time_point::max();
+        uint64_t scheduled_tick_ = 0;  // tick of the live entry, 0 if none
+    };
+
+    explicit TimerWheel(boost::asio::io_service& io_service,
+                        std::chrono::milliseconds tick_duration = kDefaultTick,
+                        size_t num_slots = kDefaultSlots);
+
+    // Starts the periodic tick on the io_service
+    void start();
+
+    void stop();
+
+    // Sets or moves the client's deadline
+    void set_deadline(const std::shared_ptr<Client>& client, Clock::time_point deadline);
+
+    // Disarms the client's deadline; its entry is dropped when it comes up
+    void clear_deadline(Client& client);
+
+    // Whether the client's deadline has passed
+    bool expired(const Client& client, Clock::time_point now = Clock::now()) const;
+
+    // Processes every tick up to now and fires expired clients. Called by
+    // the timer; public so tests can drive the wheel without an io_service.
+    void advance(Clock::time_point now);
+
+    // Number of live and stale entries in the wheel (for tests/metrics)
+    size_t size() const;
+
+private:
+    struct Entry {
+        std::weak_ptr<Client> client;
+        uint64_t tick;
+    };
+
+    void schedule_tick();
+
+    uint64_t tick_for(Clock::time_point deadline) const;
+
+    void insert(const std::shared_ptr<Client>& client, Clock::time_point deadline);
+
+    boost::asio::steady_timer timer_;
+    std::chrono::milliseconds tick_duration_;
+    Clock::time_point base_;
+    uint64_t current_tick_ = 0;
+    bool running_ = false;
+
+    mutable std::mutex mutex_;
+    std::vector<std::vector<Entry>> slots_;
+};
+
+#endif
@@ -0,0 +1,23 @@
+#include "blocking_executor.h"
+#include <boost/asio/post.hpp>
+
+BlockingExecutor::BlockingExecutor(size_t num_threads, size_t max_pending)
+    : pool_(num_threads), max_pending_(max_pending) {}
+
+BlockingExecutor::~BlockingExecutor() {
+    pool_.join();
+}
+
+bool BlockingExecutor::submit(std::function<void()> task) {
+    // Reserve a slot first so concurrent submits cannot overshoot the limit
+    if (pending_.fetch_add(1) >= max_pending_) {
+        pending_.fetch_sub(1);
+        return false;
+    }
+
+    boost::asio::post(pool_, [this, task = std::move(task)]() {
+        task();
+        pending_.fetch_sub(1);
+    });
+    return true;
+}
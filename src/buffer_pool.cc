@@ -0,0 +1,88 @@
+#include "buffer_pool.h"
+#include <algorithm>
+
+BufferPool::Buffer::Buffer(BufferPool* pool, std::unique_ptr<char[]> data, size_t size)
+    : pool_(pool), data_(std::move(data)), size_(size) {}
+
+BufferPool::Buffer::~Buffer() {
+    release();
+}
+
+BufferPool::Buffer::Buffer(Buffer&& other) noexcept
+    : pool_(other.pool_), data_(std::move(other.data_)), size_(other.size_) {
+    other.pool_ = nullptr;
+    other.size_ = 0;
+}
+
+BufferPool::Buffer& BufferPool::Buffer::operator=(Buffer&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool_ = other.pool_;
+        data_ = std::move(other.data_);
+        size_ = other.size_;
+        other.pool_ = nullptr;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+void BufferPool::Buffer::release() {
+    if (pool_ && data_) {
+        pool_->recycle(std::move(data_), size_);
+    }
+    data_.reset();
+    pool_ = nullptr;
+    size_ = 0;
+}
+
+BufferPool::BufferPool(size_t max_cached_per_class)
+    : max_cached_per_class_(max_cached_per_class),
+      free_lists_(class_index(kMaxBufferSize) + 1) {}
+
+size_t BufferPool::size_class(size_t min_size) {
+    size_t size = kMinBufferSize;
+    while (size < min_size && size < kMaxBufferSize) {
+        size <<= 1;
+    }
+    return size;
+}
+
+size_t BufferPool::class_index(size_t size) {
+    size_t index = 0;
+    for (size_t s = kMinBufferSize; s < size; s <<= 1) {
+        ++index;
+    }
+    return index;
+}
+
+BufferPool::Buffer BufferPool::acquire(size_t min_size) {
+    size_t size = size_class(min_size);
+    FreeList& list = free_lists_[class_index(size)];
+    {
+        std::lock_guard<std::mutex> lock(list.mutex);
+        if (!list.buffers.empty()) {
+            std::unique_ptr<char[]> data = std::move(list.buffers.back());
+            list.buffers.pop_back();
+            return Buffer(this, std::move(data), size);
+        }
+    }
+    return Buffer(this, std::unique_ptr<char[]>(new char[size]), size);
+}
+
+void BufferPool::recycle(std::unique_ptr<char[]> data, size_t size) {
+    FreeList& list = free_lists_[class_index(size)];
+    std::lock_guard<std::mutex> lock(list.mutex);
+    if (list.buffers.size() < max_cached_per_class_) {
+        list.buffers.push_back(std::move(data));
+    }
+    // Otherwise the unique_ptr frees the buffer on return
+}
+
+size_t BufferPool::cached_buffers() const {
+    size_t total = 0;
+    for (const FreeList& list : free_lists_) {
+        std::lock_guard<std::mutex> lock(list.mutex);
+        total += list.buffers.size();
+    }
+    return total;
+}
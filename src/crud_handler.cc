@@ -3,6 +3,30 @@
 #include <vector>
 #include <iostream>
 #include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+// One chunked request body, for CrudHandler::handle_streamed_request()
+class CrudBodySink : public BodySink {
+public:
+    explicit CrudBodySink(bool keep) : keep_(keep) {}
+
+    // Session's max_body_size already bounds how much arrives here
+    void write(std::string_view data) override {
+        if (keep_) {
+            body_.append(data);
+        }
+    }
+
+    std::string& body() { return body_; }
+
+private:
+    const bool keep_;
+    std::string body_;
+};
+
+}
 
 CrudHandler::CrudHandler(const std::string& route_prefix,
                          std::shared_ptr<FilesystemInterface> filesystem)
@@ -100,9 +124,21 @@ HttpResponse CrudHandler::handle_request(const HttpRequest& request) {
     return response;
 }
 
+std::unique_ptr<BodySink> CrudHandler::begin_body(const HttpRequest& head) {
+    return std::make_unique<CrudBodySink>(head.method() == "POST" || head.method() == "PUT");
+}
+
+HttpResponse CrudHandler::handle_streamed_request(const HttpRequest& request, BodySink& body) {
+    // Session only passes back the sink begin_body() made
+    CrudBodySink& sink = static_cast<CrudBodySink&>(body);
+    HttpRequest complete = request;
+    complete.set_body(sink.body());
+    return handle_request(complete);
+}
+
 HttpResponse CrudHandler::handle_post(const HttpRequest& request,
                                       const Entity& entity) {
-    std::string body = request.body();
+    std::string body(request.body());
 
     std::string new_id;
     try {
@@ -157,7 +193,20 @@ HttpResponse CrudHandler::handle_get(const HttpRequest& request,
         return response;
     }
 
-    std::string entity_data = filesystem_->read_entity(entity, id);
+    // Another request may delete it before it is read
+    std::string entity_data;
+    try {
+        entity_data = filesystem_->read_entity(entity, id);
+    } catch (const std::runtime_error&) {
+        HttpResponse response(
+            "HTTP/1.1",
+            404,
+            "Not Found",
+            {{"Content-Type", "text/html"}},
+            "Entity not found"
+        );
+        return response;
+    }
     
     // Return the JSON data
     HttpResponse response(
@@ -185,7 +234,7 @@ HttpResponse CrudHandler::handle_put(const HttpRequest& request,
         return response;
     }
 
-    std::string body = request.body();
+    std::string body(request.body());
 
     // Update the entity with new data
     bool ok = filesystem_->write_entity(entity, id, body);
@@ -269,8 +318,14 @@ HttpResponse CrudHandler::handle_list(const HttpRequest& request,
             continue;
         }
         
-        // Read the entity data to check filters
-        std::string entity_data = filesystem_->read_entity(entity, id);
+        // Read the entity data to check filters; skip it if it was deleted
+        // since it was listed
+        std::string entity_data;
+        try {
+            entity_data = filesystem_->read_entity(entity, id);
+        } catch (const std::runtime_error&) {
+            continue;
+        }
         
         // Check if this entry matches the filters
         bool matches = true;
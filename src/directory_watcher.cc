@@ -0,0 +1,218 @@
+#include "directory_watcher.h"
+#include "logger.h"
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kWatchMask = IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_CREATE |
+                                IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                                IN_DELETE_SELF | IN_MOVE_SELF;
+
+}
+
+DirectoryWatcher::DirectoryWatcher() {
+    inotify_fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (inotify_fd_ < 0 || wake_fd_ < 0) {
+        Logger::getLogger()->logErrorFile(std::string("inotify unavailable: ") + std::strerror(errno));
+        if (inotify_fd_ >= 0) {
+            ::close(inotify_fd_);
+            inotify_fd_ = -1;
+        }
+        return;
+    }
+    thread_ = std::thread([this]() { run(); });
+}
+
+DirectoryWatcher::~DirectoryWatcher() {
+    if (thread_.joinable()) {
+        uint64_t one = 1;
+        ssize_t ignored = ::write(wake_fd_, &one, sizeof(one));
+        (void)ignored;
+        thread_.join();
+    }
+    if (inotify_fd_ >= 0) {
+        ::close(inotify_fd_);
+    }
+    if (wake_fd_ >= 0) {
+        ::close(wake_fd_);
+    }
+}
+
+std::shared_ptr<DirectoryWatcher> DirectoryWatcher::shared() {
+    static std::mutex mutex;
+    static std::weak_ptr<DirectoryWatcher> instance;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<DirectoryWatcher> watcher = instance.lock();
+    if (!watcher) {
+        watcher = std::make_shared<DirectoryWatcher>();
+        instance = watcher;
+    }
+    return watcher;
+}
+
+std::string DirectoryWatcher::parent_directory(const std::string& path) {
+    size_t slash = path.rfind('/');
+    if (slash == std::string::npos) {
+        return ".";
+    }
+    return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+std::string DirectoryWatcher::join_path(const std::string& directory, const std::string& name) {
+    return directory.back() == '/' ? directory + name : directory + "/" + name;
+}
+
+DirectoryWatcher::Subscription DirectoryWatcher::subscribe(Callbacks callbacks) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Subscription subscription = next_subscription_++;
+    subscribers_[subscription] = std::move(callbacks);
+    return subscription;
+}
+
+void DirectoryWatcher::unsubscribe(Subscription subscription) {
+    std::lock_guard<std::mutex> dispatch_lock(dispatch_mutex_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    subscribers_.erase(subscription);
+    for (auto it = watches_.begin(); it != watches_.end();) {
+        it->second.subscribers.erase(subscription);
+        if (!it->second.subscribers.empty()) {
+            ++it;
+            continue;
+        }
+        ::inotify_rm_watch(inotify_fd_, it->second.wd);
+        watched_dirs_.erase(it->second.wd);
+        it = watches_.erase(it);
+    }
+}
+
+bool DirectoryWatcher::watch(Subscription subscription, const std::string& directory) {
+    if (!active()) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = watches_.find(directory);
+    if (it != watches_.end()) {
+        it->second.subscribers.insert(subscription);
+        return true;
+    }
+    int wd = ::inotify_add_watch(inotify_fd_, directory.c_str(), kWatchMask | IN_ONLYDIR);
+    if (wd < 0) {
+        return false;
+    }
+    // The same directory under another name gets the same descriptor
+    auto existing = watched_dirs_.find(wd);
+    if (existing != watched_dirs_.end()) {
+        watches_[existing->second].subscribers.insert(subscription);
+        return true;
+    }
+    watches_[directory] = Watch{wd, {subscription}};
+    watched_dirs_[wd] = directory;
+    return true;
+}
+
+size_t DirectoryWatcher::watches() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return watches_.size();
+}
+
+void DirectoryWatcher::run() {
+    alignas(struct inotify_event) char buffer[16 * 1024];
+
+    while (true) {
+        struct pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            Logger::getLogger()->logErrorFile(std::string("Directory watcher failed: ") + std::strerror(errno));
+            std::lock_guard<std::mutex> dispatch_lock(dispatch_mutex_);
+            std::vector<std::function<void()>> overflows;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                for (const auto& [subscription, callbacks] : subscribers_) {
+                    overflows.push_back(callbacks.overflow);
+                }
+            }
+            for (const auto& overflow : overflows) {
+                overflow();
+            }
+            return;
+        }
+        if (fds[1].revents) {
+            return;
+        }
+
+        ssize_t n;
+        while ((n = ::read(inotify_fd_, buffer, sizeof(buffer))) > 0) {
+            // Resolve the batch under the lock, report it without. Lost
+            // events go to every subscriber, the others only to those
+            // watching the directory.
+            std::lock_guard<std::mutex> dispatch_lock(dispatch_mutex_);
+            std::vector<std::function<void()>> calls;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                bool overflow = false;
+                for (char* p = buffer; p < buffer + n;) {
+                    const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+                    p += sizeof(struct inotify_event) + event->len;
+
+                    if (event->mask & IN_Q_OVERFLOW) {
+                        overflow = true;
+                        continue;
+                    }
+
+                    auto dir = watched_dirs_.find(event->wd);
+                    if (dir == watched_dirs_.end()) {
+                        continue;
+                    }
+
+                    const std::string& directory = dir->second;
+                    const Watch& watch = watches_[directory];
+                    if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) {
+                        for (Subscription subscription : watch.subscribers) {
+                            auto removed = subscribers_[subscription].removed;
+                            calls.push_back([removed, directory]() { removed(directory); });
+                        }
+                        if (event->mask & IN_IGNORED) {
+                            watches_.erase(directory);
+                            watched_dirs_.erase(dir);
+                        } else {
+                            ::inotify_rm_watch(inotify_fd_, event->wd);
+                        }
+                        continue;
+                    }
+
+                    if (event->len > 0) {
+                        std::string path = join_path(directory, event->name);
+                        for (Subscription subscription : watch.subscribers) {
+                            auto changed = subscribers_[subscription].changed;
+                            calls.push_back([changed, path]() { changed(path); });
+                        }
+                    }
+                }
+
+                if (overflow) {
+                    // Ahead of the rest of the batch, as those events are
+                    // no more trustworthy
+                    std::vector<std::function<void()>> overflows;
+                    for (const auto& [subscription, callbacks] : subscribers_) {
+                        overflows.push_back(callbacks.overflow);
+                    }
+                    calls.insert(calls.begin(), overflows.begin(), overflows.end());
+                }
+            }
+
+            for (const auto& call : calls) {
+                call();
+            }
+        }
+    }
+}
@@ -0,0 +1,191 @@
+#include "file_cache.h"
+#include "logger.h"
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <sys/stat.h>
+
+size_t FileCache::Entry::cost() const {
+    size_t total = body.size() + head.size();
+    for (const auto& [coding, encoded] : encodings) {
+        total += encoded.body.size() + encoded.head.size();
+    }
+    return total;
+}
+
+FileCache::FileCache(size_t max_bytes, std::shared_ptr<DirectoryWatcher> watcher)
+    : max_bytes_(max_bytes),
+      watcher_(std::move(watcher)) {
+    subscription_ = watcher_->subscribe({[this](const std::string& path) {
+                                             std::lock_guard<std::mutex> lock(mutex_);
+                                             invalidate_locked(path);
+                                         },
+                                         [this](const std::string& directory) { drop_directory(directory); },
+                                         [this]() { clear(); }});
+    if (!watching()) {
+        Logger::getLogger()->logErrorFile("File cache disabled, inotify unavailable");
+    }
+}
+
+// Before any member goes, as the callbacks touch them
+FileCache::~FileCache() {
+    watcher_->unsubscribe(subscription_);
+}
+
+bool FileCache::stat_file(const std::string& path, int64_t& mtime_ns, uint64_t& size,
+                          uint64_t* inode) {
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+    mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    size = static_cast<uint64_t>(st.st_size);
+    if (inode) {
+        *inode = static_cast<uint64_t>(st.st_ino);
+    }
+    return true;
+}
+
+std::shared_ptr<const FileCache::Entry> FileCache::lookup(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(path);
+    if (it == entries_.end()) {
+        return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second.lru);
+    return it->second.entry;
+}
+
+void FileCache::insert(const std::string& path, std::shared_ptr<const Entry> entry) {
+    if (!watching() || !entry || entry->cost() > max_bytes_) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!watch_directory(DirectoryWatcher::parent_directory(path))) {
+        return;
+    }
+    for (const Dependency& dependency : entry->dependencies) {
+        if (!watch_directory(DirectoryWatcher::parent_directory(dependency.path))) {
+            return;
+        }
+    }
+
+    // The watches are in place now, so any later change will be seen. A
+    // change between reading the files and here shows up as a different stat.
+    if (!unchanged(path, true, entry->mtime_ns, entry->size)) {
+        return;
+    }
+    for (const Dependency& dependency : entry->dependencies) {
+        if (!unchanged(dependency.path, dependency.exists, dependency.mtime_ns, dependency.size)) {
+            return;
+        }
+    }
+
+    auto existing = entries_.find(path);
+    if (existing != entries_.end()) {
+        remove_locked(existing);
+    }
+
+    bytes_ += entry->cost();
+    lru_.push_front(path);
+    for (const Dependency& dependency : entry->dependencies) {
+        dependents_.emplace(dependency.path, path);
+    }
+    entries_[path] = Slot{std::move(entry), lru_.begin()};
+
+    while (bytes_ > max_bytes_) {
+        remove_locked(entries_.find(lru_.back()));
+    }
+}
+
+void FileCache::invalidate(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    invalidate_locked(path);
+}
+
+void FileCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    lru_.clear();
+    dependents_.clear();
+    bytes_ = 0;
+}
+
+size_t FileCache::bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_;
+}
+
+size_t FileCache::entries() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+// Caller holds mutex_
+bool FileCache::watch_directory(const std::string& directory) {
+    if (!watcher_->watch(subscription_, directory)) {
+        Logger::getLogger()->logErrorFile("Cannot watch " + directory + ": " + std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+// The directory itself went away; drop everything in it
+void FileCache::drop_directory(const std::string& directory) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string prefix = DirectoryWatcher::join_path(directory, "");
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        auto next = std::next(it);
+        if (it->first.compare(0, prefix.size(), prefix) == 0) {
+            remove_locked(it);
+        }
+        it = next;
+    }
+}
+
+bool FileCache::unchanged(const std::string& path, bool exists, int64_t mtime_ns, uint64_t size) const {
+    int64_t current_mtime_ns = 0;
+    uint64_t current_size = 0;
+    if (!stat_file(path, current_mtime_ns, current_size)) {
+        return !exists;
+    }
+    return exists && current_mtime_ns == mtime_ns && current_size == size;
+}
+
+// Drops path and every entry built from it. Caller holds mutex_.
+void FileCache::invalidate_locked(const std::string& path) {
+    auto it = entries_.find(path);
+    if (it != entries_.end()) {
+        remove_locked(it);
+    }
+
+    auto range = dependents_.equal_range(path);
+    std::vector<std::string> keys;
+    for (auto dependent = range.first; dependent != range.second; ++dependent) {
+        keys.push_back(dependent->second);
+    }
+    for (const std::string& key : keys) {
+        auto entry = entries_.find(key);
+        if (entry != entries_.end()) {
+            remove_locked(entry);
+        }
+    }
+}
+
+// Caller holds mutex_
+void FileCache::remove_locked(std::unordered_map<std::string, Slot>::iterator it) {
+    const Entry& entry = *it->second.entry;
+    for (const Dependency& dependency : entry.dependencies) {
+        auto range = dependents_.equal_range(dependency.path);
+        for (auto dependent = range.first; dependent != range.second; ++dependent) {
+            if (dependent->second == it->first) {
+                dependents_.erase(dependent);
+                break;
+            }
+        }
+    }
+    bytes_ -= entry.cost();
+    lru_.erase(it->second.lru);
+    entries_.erase(it);
+}
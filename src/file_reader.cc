@@ -0,0 +1,295 @@
+#include "file_reader.h"
+#include "logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+// pread() on the blocking executor
+class ThreadedFileReader : public FileReader {
+public:
+    explicit ThreadedFileReader(std::shared_ptr<BlockingExecutor> executor)
+        : executor_(std::move(executor)) {}
+
+    bool read(int fd, uint64_t offset, char* data, size_t length, Completion done) override {
+        return executor_->submit([fd, offset, data, length, done = std::move(done)]() {
+            ssize_t n;
+            do {
+                n = ::pread(fd, data, length, static_cast<off_t>(offset));
+            } while (n < 0 && errno == EINTR);
+            done(n < 0 ? -errno : n);
+        });
+    }
+
+    const char* backend() const override { return "threads"; }
+
+private:
+    std::shared_ptr<BlockingExecutor> executor_;
+};
+
+int io_uring_setup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+// One submission queue guarded by a mutex, and a thread that waits for
+// completions and runs their callbacks. Each read carries its heap-allocated
+// Completion as user_data; 0 marks the NOP that stops the thread.
+class IoUringFileReader : public FileReader {
+public:
+    IoUringFileReader(unsigned entries, std::shared_ptr<FileReader> overflow)
+        : overflow_(std::move(overflow)) {
+        io_uring_params params{};
+        ring_fd_ = io_uring_setup(entries, &params);
+        if (ring_fd_ < 0) {
+            return;
+        }
+        // IORING_OP_READ arrived in 5.6, just before this feature flag
+        if (!(params.features & IORING_FEAT_FAST_POLL) || !map_rings(params)) {
+            unmap_rings();
+            ::close(ring_fd_);
+            ring_fd_ = -1;
+            return;
+        }
+        capacity_ = params.sq_entries;
+        reaper_ = std::thread([this]() { reap(); });
+    }
+
+    ~IoUringFileReader() override {
+        if (ring_fd_ < 0) {
+            return;
+        }
+        {
+            // Callbacks of reads still in flight must run before the ring
+            // goes away
+            std::unique_lock<std::mutex> lock(mutex_);
+            drained_.wait(lock, [this]() { return in_flight_ == 0; });
+            io_uring_sqe* sqe = next_sqe();
+            if (sqe) {
+                sqe->opcode = IORING_OP_NOP;
+                sqe->user_data = 0;
+                submit_locked();
+            }
+        }
+        reaper_.join();
+        unmap_rings();
+        ::close(ring_fd_);
+    }
+
+    bool ok() const { return ring_fd_ >= 0; }
+
+    bool read(int fd, uint64_t offset, char* data, size_t length, Completion done) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        io_uring_sqe* sqe = in_flight_ < capacity_ - 1 ? next_sqe() : nullptr;
+        if (!sqe) {
+            // Ring full; keep one slot for the shutdown NOP
+            lock.unlock();
+            return overflow_ && overflow_->read(fd, offset, data, length, std::move(done));
+        }
+
+        auto* completion = new Completion(std::move(done));
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = fd;
+        sqe->off = offset;
+        sqe->addr = reinterpret_cast<uint64_t>(data);
+        sqe->len = static_cast<uint32_t>(length);
+        sqe->user_data = reinterpret_cast<uint64_t>(completion);
+        ++in_flight_;
+        if (!submit_locked()) {
+            --in_flight_;
+            delete completion;
+            return false;
+        }
+        return true;
+    }
+
+    const char* backend() const override { return "io_uring"; }
+
+private:
+    bool map_rings(const io_uring_params& params) {
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        single_mmap_ = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap_) {
+            sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+        }
+
+        sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          ring_fd_, IORING_OFF_SQ_RING);
+        if (sq_ring_ == MAP_FAILED) {
+            sq_ring_ = nullptr;
+            return false;
+        }
+        cq_ring_ = single_mmap_ ? sq_ring_
+                                : ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                                         MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+        if (cq_ring_ == MAP_FAILED) {
+            cq_ring_ = nullptr;
+            return false;
+        }
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            ring_fd_, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+            return false;
+        }
+        sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+        char* sq = static_cast<char*>(sq_ring_);
+        sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_entries_ = params.sq_entries;
+        sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+        char* cq = static_cast<char*>(cq_ring_);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    void unmap_rings() {
+        if (sqes_) {
+            ::munmap(sqes_, sqes_size_);
+        }
+        if (cq_ring_ && !single_mmap_) {
+            ::munmap(cq_ring_, cq_ring_size_);
+        }
+        if (sq_ring_) {
+            ::munmap(sq_ring_, sq_ring_size_);
+        }
+        sqes_ = nullptr;
+        cq_ring_ = sq_ring_ = nullptr;
+    }
+
+    // Zeroed entry at the tail of the submission queue, or nullptr if full.
+    // Caller holds mutex_.
+    io_uring_sqe* next_sqe() {
+        unsigned tail = *sq_tail_;
+        unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+        if (tail - head >= sq_entries_) {
+            return nullptr;
+        }
+        io_uring_sqe* sqe = &sqes_[tail & sq_mask_];
+        std::memset(sqe, 0, sizeof(*sqe));
+        return sqe;
+    }
+
+    // Publishes the entry from next_sqe() and tells the kernel
+    bool submit_locked() {
+        unsigned tail = *sq_tail_;
+        sq_array_[tail & sq_mask_] = tail & sq_mask_;
+        __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+
+        int result;
+        do {
+            result = io_uring_enter(ring_fd_, 1, 0, 0);
+        } while (result < 0 && errno == EINTR);
+        if (result < 0) {
+            // Take the entry back so the queue stays consistent
+            __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+            Logger::getLogger()->logErrorFile(std::string("io_uring submit failed: ") + std::strerror(errno));
+            return false;
+        }
+        return true;
+    }
+
+    void reap() {
+        bool stopping = false;
+        while (!stopping) {
+            int result = io_uring_enter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS);
+            if (result < 0 && errno != EINTR) {
+                Logger::getLogger()->logErrorFile(std::string("io_uring wait failed: ") + std::strerror(errno));
+                return;
+            }
+
+            unsigned head = *cq_head_;
+            unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+            size_t completed = 0;
+            for (; head != tail; ++head) {
+                const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+                if (cqe.user_data == 0) {
+                    stopping = true;
+                    continue;
+                }
+                std::unique_ptr<Completion> completion(reinterpret_cast<Completion*>(cqe.user_data));
+                (*completion)(cqe.res);
+                ++completed;
+            }
+            __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+
+            if (completed > 0) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                in_flight_ -= completed;
+                if (in_flight_ == 0) {
+                    drained_.notify_all();
+                }
+            }
+        }
+    }
+
+    int ring_fd_ = -1;
+    std::shared_ptr<FileReader> overflow_;
+
+    void* sq_ring_ = nullptr;
+    void* cq_ring_ = nullptr;
+    size_t sq_ring_size_ = 0;
+    size_t cq_ring_size_ = 0;
+    bool single_mmap_ = false;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_entries_ = 0;
+    unsigned* sq_array_ = nullptr;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+
+    // Guards the submission queue and in_flight_
+    std::mutex mutex_;
+    std::condition_variable drained_;
+    size_t in_flight_ = 0;
+    size_t capacity_ = 0;
+    std::thread reaper_;
+};
+
+}
+
+std::shared_ptr<FileReader> FileReader::create(std::shared_ptr<BlockingExecutor> executor, unsigned entries) {
+    std::shared_ptr<FileReader> threaded = create_threaded(std::move(executor));
+    std::shared_ptr<FileReader> ring = create_io_uring(entries, threaded);
+    if (ring) {
+        return ring;
+    }
+    Logger::getLogger()->logTraceFile("io_uring unavailable, reading files on the blocking executor");
+    return threaded;
+}
+
+std::shared_ptr<FileReader> FileReader::create_io_uring(unsigned entries, std::shared_ptr<FileReader> overflow) {
+    auto reader = std::make_shared<IoUringFileReader>(entries, std::move(overflow));
+    if (!reader->ok()) {
+        return nullptr;
+    }
+    return reader;
+}
+
+std::shared_ptr<FileReader> FileReader::create_threaded(std::shared_ptr<BlockingExecutor> executor) {
+    return std::make_shared<ThreadedFileReader>(std::move(executor));
+}
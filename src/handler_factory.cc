@@ -8,9 +8,54 @@
 #include "health_handler.h"
 #include "sleep_handler.h"
 #include "mock_filesystem.h"
+#include "log_structured_filesystem.h"
+#include <filesystem>
+#include <map>
+#include <mutex>
 #include <sstream>
 
+// One store per CRUD root, shared by every location using it and kept
+// across config reloads: two stores appending to the same segments would
+// corrupt them. Options only apply when the root is first opened.
+static std::shared_ptr<LogStructuredFilesystem> crud_store(const HandlerConfig& config,
+                                                           const std::string& root) {
+    static std::mutex mutex;
+    static std::map<std::string, std::shared_ptr<LogStructuredFilesystem>> stores;
+
+    std::string key = std::filesystem::absolute(root).lexically_normal().string();
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<LogStructuredFilesystem>& store = stores[key];
+    if (!store) {
+        LogStructuredFilesystem::Options options;
+        auto segment_it = config.settings.find("segment_size");
+        if (segment_it != config.settings.end()) {
+            options.segment_bytes = std::stoull(segment_it->second);
+        }
+        auto sync_it = config.settings.find("sync");
+        if (sync_it != config.settings.end()) {
+            options.sync = sync_it->second == "on" || sync_it->second == "true";
+        }
+        auto reuse_it = config.settings.find("reuse_ids");
+        if (reuse_it != config.settings.end()) {
+            options.reuse_ids = reuse_it->second == "on" || reuse_it->second == "true";
+        }
+        store = std::make_shared<LogStructuredFilesystem>(root, options);
+    }
+    return store;
+}
+
 std::unique_ptr<RequestHandler> HandlerFactory::create_handler(const HandlerConfig& config, std::string path) const {
+        std::unique_ptr<RequestHandler> handler = create_typed_handler(config, path);
+
+        // "blocking on|off;" overrides the handler's own default
+        auto it = config.settings.find("blocking");
+        if (handler && it != config.settings.end()) {
+            handler->set_blocking(it->second == "on" || it->second == "true");
+        }
+        return handler;
+}
+
+std::unique_ptr<RequestHandler> HandlerFactory::create_typed_handler(const HandlerConfig& config, const std::string& path) const {
         if (config.type == "EchoHandler") {
             return std::make_unique<EchoHandler>();
         } 
@@ -24,15 +69,46 @@ std::unique_ptr<RequestHandler> HandlerFactory::create_handler(const HandlerConf
             }
             std::string root = it->second;
 
+            std::unique_ptr<FileHandler> handler;
             auto ext_it = config.settings.find("supported_extensions");
             if (ext_it != config.settings.end()) {
                 std::unordered_set<std::string> extensions = parse_extensions(ext_it->second);
-                return std::make_unique<FileHandler>(root, path, extensions);
+                handler = std::make_unique<FileHandler>(root, path, extensions);
             } else {
-                return std::make_unique<FileHandler>(root, path);
+                handler = std::make_unique<FileHandler>(root, path);
+            }
+
+            auto threshold_it = config.settings.find("stream_threshold");
+            if (threshold_it != config.settings.end()) {
+                handler->set_stream_threshold(std::stoull(threshold_it->second));
+            }
+
+            auto cache_it = config.settings.find("cache_size");
+            if (cache_it != config.settings.end()) {
+                handler->enable_cache(std::stoull(cache_it->second));
             }
+
+            auto mmap_it = config.settings.find("mmap_threshold");
+            if (mmap_it != config.settings.end()) {
+                handler->enable_mmap(std::stoull(mmap_it->second));
+            }
+
+            auto stat_it = config.settings.find("stat_cache");
+            if (stat_it != config.settings.end()) {
+                auto ttl_it = config.settings.find("stat_cache_ttl");
+                std::chrono::milliseconds ttl = ttl_it != config.settings.end()
+                    ? std::chrono::milliseconds(std::stoull(ttl_it->second))
+                    : StatCache::kDefaultTtl;
+                handler->enable_stat_cache(std::stoull(stat_it->second), ttl);
+            }
+            return handler;
         }
         else if (config.type == "CrudHandler") {
+            // With a root, entities are kept on disk under it
+            auto root_it = config.settings.find("root");
+            if (root_it != config.settings.end()) {
+                return std::make_unique<CrudHandler>(path, crud_store(config, root_it->second));
+            }
             static std::shared_ptr<MockFilesystem> crud_fs = std::make_shared<MockFilesystem>();
             return std::make_unique<CrudHandler>(path, crud_fs);
         }
@@ -1,4 +1,6 @@
 #include "http_helper.h"
+#include <algorithm>
+#include <cctype>
 #include <sstream>
 
 bool detect_http_request(std::string& buffer) {
@@ -14,3 +16,235 @@ MalformedType check_malformed_request(const std::string& buffer) {
     }
     return MalformedType::None;
 }
+
+bool iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) !=
+            std::tolower(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string reason_phrase(int status_code) {
+    switch (status_code) {
+        case 200: return "OK";
+        case 201: return "Created";
+        case 204: return "No Content";
+        case 206: return "Partial Content";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 408: return "Request Timeout";
+        case 413: return "Content Too Large";
+        case 416: return "Range Not Satisfiable";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        case 503: return "Service Unavailable";
+        default:  return "Unknown";
+    }
+}
+
+namespace {
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+// q=0, q=0.0, q=0.000 and so on
+bool is_zero_quality(std::string_view params) {
+    size_t pos = 0;
+    while (pos < params.size()) {
+        size_t end = params.find(';', pos);
+        std::string_view param = trim(params.substr(pos, end == std::string_view::npos ? std::string_view::npos : end - pos));
+        if (param.size() >= 2 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=') {
+            std::string_view value = param.substr(2);
+            return !value.empty() && value.find_first_not_of("0.") == std::string_view::npos;
+        }
+        if (end == std::string_view::npos) {
+            break;
+        }
+        pos = end + 1;
+    }
+    return false;
+}
+
+}
+
+bool accepts_encoding(std::string_view accept_encoding, std::string_view coding) {
+    bool wildcard = false;
+    size_t pos = 0;
+    while (pos <= accept_encoding.size()) {
+        size_t end = accept_encoding.find(',', pos);
+        std::string_view item = accept_encoding.substr(pos, end == std::string_view::npos ? std::string_view::npos : end - pos);
+
+        size_t semicolon = item.find(';');
+        std::string_view name = trim(item.substr(0, semicolon));
+        std::string_view params = semicolon == std::string_view::npos ? std::string_view() : item.substr(semicolon + 1);
+
+        if (iequals(name, coding)) {
+            return !is_zero_quality(params);
+        }
+        if (name == "*") {
+            wildcard = !is_zero_quality(params);
+        }
+
+        if (end == std::string_view::npos) {
+            break;
+        }
+        pos = end + 1;
+    }
+    return wildcard;
+}
+
+std::string http_date(time_t time) {
+    struct tm tm;
+    gmtime_r(&time, &tm);
+    char buffer[32];
+    size_t n = strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return std::string(buffer, n);
+}
+
+std::optional<time_t> parse_http_date(std::string_view date) {
+    // strptime's %a/%b are locale dependent, so match the names by hand
+    static const char* const kMonths[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                          "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+    date = trim(date);
+    if (date.size() != 29 || date.substr(3, 2) != ", " || date.substr(25) != " GMT") {
+        return std::nullopt;
+    }
+
+    int month = -1;
+    for (int i = 0; i < 12; ++i) {
+        if (date.substr(8, 3) == kMonths[i]) {
+            month = i;
+        }
+    }
+
+    std::string digits(date.substr(5, 2));
+    digits += std::string(date.substr(12, 4)) + std::string(date.substr(17, 2)) +
+              std::string(date.substr(20, 2)) + std::string(date.substr(23, 2));
+    if (month < 0 || digits.find_first_not_of("0123456789") != std::string::npos ||
+        date[7] != ' ' || date[11] != ' ' || date[16] != ' ' || date[19] != ':' || date[22] != ':') {
+        return std::nullopt;
+    }
+
+    struct tm tm = {};
+    tm.tm_mday = std::stoi(digits.substr(0, 2));
+    tm.tm_mon = month;
+    tm.tm_year = std::stoi(digits.substr(2, 4)) - 1900;
+    tm.tm_hour = std::stoi(digits.substr(6, 2));
+    tm.tm_min = std::stoi(digits.substr(8, 2));
+    tm.tm_sec = std::stoi(digits.substr(10, 2));
+    return timegm(&tm);
+}
+
+bool etag_matches(std::string_view if_none_match, std::string_view etag) {
+    auto opaque = [](std::string_view tag) {
+        return tag.substr(0, 2) == "W/" ? tag.substr(2) : tag;
+    };
+
+    size_t pos = 0;
+    while (pos <= if_none_match.size()) {
+        size_t end = if_none_match.find(',', pos);
+        std::string_view tag = trim(if_none_match.substr(pos, end == std::string_view::npos ? std::string_view::npos : end - pos));
+        if (tag == "*" || (!tag.empty() && opaque(tag) == opaque(etag))) {
+            return true;
+        }
+        if (end == std::string_view::npos) {
+            break;
+        }
+        pos = end + 1;
+    }
+    return false;
+}
+
+namespace {
+
+bool parse_uint(std::string_view digits, uint64_t& value) {
+    if (digits.empty() || digits.size() > 19 ||
+        digits.find_first_not_of("0123456789") != std::string_view::npos) {
+        return false;
+    }
+    value = 0;
+    for (char c : digits) {
+        value = value * 10 + static_cast<uint64_t>(c - '0');
+    }
+    return true;
+}
+
+}
+
+std::optional<std::vector<ByteRange>> parse_byte_ranges(std::string_view range, uint64_t size) {
+    range = trim(range);
+    if (range.size() < 6 || !iequals(range.substr(0, 6), "bytes=")) {
+        return std::nullopt;
+    }
+    range.remove_prefix(6);
+
+    std::vector<ByteRange> ranges;
+    size_t specs = 0;
+    size_t pos = 0;
+    while (pos <= range.size()) {
+        size_t end = range.find(',', pos);
+        std::string_view spec = trim(range.substr(pos, end == std::string_view::npos ? std::string_view::npos : end - pos));
+        pos = end == std::string_view::npos ? range.size() + 1 : end + 1;
+        if (spec.empty()) {
+            continue;
+        }
+        if (++specs > kMaxByteRanges) {
+            return std::nullopt;
+        }
+
+        size_t dash = spec.find('-');
+        if (dash == std::string_view::npos) {
+            return std::nullopt;
+        }
+        std::string_view first_text = trim(spec.substr(0, dash));
+        std::string_view last_text = trim(spec.substr(dash + 1));
+
+        uint64_t first = 0;
+        uint64_t last = 0;
+        if (first_text.empty()) {
+            // Suffix range: the final N bytes
+            uint64_t suffix = 0;
+            if (!parse_uint(last_text, suffix)) {
+                return std::nullopt;
+            }
+            if (suffix > 0 && size > 0) {
+                uint64_t length = std::min(suffix, size);
+                ranges.push_back({size - length, length});
+            }
+            continue;
+        }
+
+        if (!parse_uint(first_text, first)) {
+            return std::nullopt;
+        }
+        if (last_text.empty()) {
+            last = size > 0 ? size - 1 : 0;
+        } else if (!parse_uint(last_text, last) || last < first) {
+            return std::nullopt;
+        }
+
+        if (first < size) {
+            last = std::min(last, size - 1);
+            ranges.push_back({first, last - first + 1});
+        }
+    }
+
+    if (specs == 0) {
+        return std::nullopt;
+    }
+    return ranges;
+}
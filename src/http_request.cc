@@ -1,75 +1,29 @@
 // Disclaimer: Most of this class is from Claude Sonnet 4.5, with some of my modifications (Tony)
 #include "http_request.h"
+#include "http_request_parser.h"
+#include "http_helper.h"
 #include <sstream>
 #include <algorithm>
 #include <cctype>
 
 HttpRequest HttpRequest::parse(const std::string& raw_request) {
-    HttpRequest request;
-    request.raw_request_ = raw_request;
-    std::istringstream stream(raw_request);
-    
-    // Parse request line: "GET /path HTTP/1.1"
-    if (!(stream >> request.method_ >> request.path_ >> request.version_)) {
-        // Return invalid request
-        request.method_ = "";
-        request.path_ = "";
-        request.version_ = "";
-        return request;
-    }
+    HttpRequestParser parser(HttpRequestParser::Mode::Lenient);
+    parser.feed(raw_request.data(), raw_request.size());
+    parser.finish();
+    return parser.take_request();
+}
 
-    request.parse_path_and_query();
-    
-    // Consume the rest of the request line
-    std::string line;
-    std::getline(stream, line);
-    
-    // Parse headers
-    while (std::getline(stream, line)) {
-        // Remove \r if present
-        if (!line.empty() && line.back() == '\r') {
-            line.pop_back();
-        }
-        
-        // Empty line marks end of headers
-        if (line.empty()) {
-            break;
-        }
-        
-        // Parse "Header-Name: value"
-        size_t colon_pos = line.find(':');
-        if (colon_pos != std::string::npos) {
-            std::string name = line.substr(0, colon_pos);
-            std::string value = line.substr(colon_pos + 1);
-            
-            // Trim whitespace from value
-            value = trim(value);
-            
-            request.headers_[name] = value;
-        }
-    }
-    
-    // Parse body (everything after headers)
-    std::ostringstream body_stream;
-    while (std::getline(stream, line)) {
-        body_stream << line << "\n";
+std::string_view HttpRequest::body() const {
+    if (body_in_raw_) {
+        return std::string_view(raw_request_).substr(body_offset_, body_length_);
     }
-    std::string body_content = body_stream.str();
-    
-    // Remove trailing newline if present
-    if (!body_content.empty() && body_content.back() == '\n') {
-        body_content.pop_back();
-    }
-    
-    request.body_ = body_content;
-    
-    return request;
+    return body_;
 }
 
 std::optional<std::string> HttpRequest::get_header(const std::string& name) const {
     // Case-insensitive header lookup
     for (const auto& [key, value] : headers_) {
-        if (to_lower(key) == to_lower(name)) {
+        if (iequals(key, name)) {
             return value;
         }
     }
@@ -115,8 +69,7 @@ bool HttpRequest::is_valid() const {
     }
 
     //  Check for single blank line after headers
-    size_t headers_end = raw_request_.find("\r\n\r\n");
-    if (headers_end == std::string::npos) {
+    if (!crlf_terminated_) {
         return false;
     }
 
@@ -137,30 +90,13 @@ std::string HttpRequest::to_string() const {
         }
     }
     
-    if (!body_.empty()) {
-        oss << "Body:\n" << body_ << "\n";
+    if (!body().empty()) {
+        oss << "Body:\n" << body() << "\n";
     }
     
     return oss.str();
 }
 
-std::string HttpRequest::trim(const std::string& str) {
-    size_t start = str.find_first_not_of(" \t\r\n");
-    if (start == std::string::npos) {
-        return "";
-    }
-    
-    size_t end = str.find_last_not_of(" \t\r\n");
-    return str.substr(start, end - start + 1);
-}
-
-std::string HttpRequest::to_lower(const std::string& str) {
-    std::string result = str;
-    std::transform(result.begin(), result.end(), result.begin(),
-                   [](unsigned char c) { return std::tolower(c); });
-    return result;
-}
-
 void HttpRequest::parse_path_and_query() {
     size_t query_pos = path_.find('?');
     
@@ -0,0 +1,535 @@
+#include "http_request_parser.h"
+#include "http_helper.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+
+HttpRequestParser::HttpRequestParser(Mode mode) : mode_(mode) {}
+
+HttpRequestParser::Result HttpRequestParser::feed(const char* data, size_t length) {
+    if (state_ == State::Error) {
+        return Result::Error;
+    }
+    compact();
+    buffer_.append(data, length);
+    return advance();
+}
+
+HttpRequestParser::Result HttpRequestParser::advance() {
+    while (state_ == State::RequestLine || state_ == State::Headers) {
+        size_t line_end = buffer_.find('\n', scan_pos_);
+        if (line_end == std::string::npos) {
+            // Remember how far we looked so the next chunk does not rescan.
+            scan_pos_ = buffer_.size();
+            if (state_ == State::RequestLine && mode_ == Mode::Strict) {
+                check_partial_request_line();
+            }
+            if (state_ != State::Error && scan_pos_ - base_ > kMaxHeaderBytes) {
+                return fail(ErrorType::HeaderTooLarge);
+            }
+            return result();
+        }
+
+        scan_pos_ = line_end + 1;
+        if (state_ == State::RequestLine) {
+            parse_request_line(line_end);
+        } else {
+            parse_header_line(line_end);
+        }
+
+        if (state_ != State::Error && state_ != State::Complete &&
+            state_ != State::Body && scan_pos_ - base_ > kMaxHeaderBytes) {
+            return fail(ErrorType::HeaderTooLarge);
+        }
+    }
+
+    if (state_ == State::Body && chunked_) {
+        return advance_chunked();
+    }
+
+    if (state_ == State::Body && mode_ == Mode::Strict &&
+        buffer_.size() - body_start_ >= content_length_) {
+        consumed_ = body_start_ + content_length_;
+        state_ = State::Complete;
+    }
+
+    return result();
+}
+
+HttpRequestParser::Result HttpRequestParser::finish() {
+    if (mode_ != Mode::Lenient || state_ == State::Error || state_ == State::Complete) {
+        return result();
+    }
+
+    // A trailing line without '\n' still counts, as it did with getline().
+    if (line_start_ < buffer_.size() &&
+        (state_ == State::RequestLine || state_ == State::Headers)) {
+        if (state_ == State::RequestLine) {
+            parse_request_line(buffer_.size());
+        } else {
+            parse_header_line(buffer_.size());
+        }
+    }
+
+    if (state_ == State::RequestLine || state_ == State::Headers) {
+        body_start_ = buffer_.size();
+    }
+
+    // Everything after the headers is the body, minus one trailing newline.
+    content_length_ = buffer_.size() - body_start_;
+    if (content_length_ > 0 && buffer_.back() == '\n') {
+        --content_length_;
+    }
+    consumed_ = buffer_.size();
+    state_ = State::Complete;
+    return result();
+}
+
+HttpRequest HttpRequestParser::take_request() {
+    HttpRequest request;
+    if (state_ != State::Complete) {
+        return request;
+    }
+
+    request.method_ = std::string(method());
+    request.path_ = std::string(target());
+    request.version_ = std::string(version());
+    for (const auto& [name, value] : headers_) {
+        request.headers_[std::string(view(name))] = std::string(view(value));
+    }
+    request.crlf_terminated_ = crlf_terminated_;
+    if (chunked_) {
+        // The framing is gone from the buffer; the decoded body lives apart
+        request.body_ = std::move(chunked_body_);
+        request.body_in_raw_ = false;
+    } else {
+        request.body_in_raw_ = true;
+        request.body_offset_ = body_start_ - base_;
+        request.body_length_ = content_length_;
+    }
+
+    if (consumed_ == buffer_.size()) {
+        // Nothing follows, so the buffer is handed over as it is
+        buffer_.erase(0, base_);
+        request.raw_request_ = std::move(buffer_);
+        buffer_.clear();
+        restart(0);
+    } else {
+        // Only this request's bytes are copied. The following ones stay in
+        // place and parsing continues from them; the buffer is compacted on
+        // the next feed(), so a run of pipelined requests is not copied over
+        // and over as each is taken.
+        request.raw_request_.assign(buffer_, base_, consumed_ - base_);
+        restart(consumed_);
+        advance();
+    }
+    request.parse_path_and_query();
+
+    return request;
+}
+
+void HttpRequestParser::reset() {
+    buffer_.clear();
+    restart(0);
+}
+
+// Start over on a new request at offset base in the buffer
+void HttpRequestParser::restart(size_t base) {
+    state_ = State::RequestLine;
+    error_ = ErrorType::None;
+    base_ = base;
+    scan_pos_ = base;
+    line_start_ = base;
+    method_ = Span{};
+    target_ = Span{};
+    version_ = Span{};
+    headers_.clear();
+    crlf_terminated_ = false;
+    body_start_ = 0;
+    content_length_ = 0;
+    consumed_ = 0;
+    chunked_ = false;
+    chunk_state_ = ChunkState::Size;
+    chunk_remaining_ = 0;
+    chunked_received_ = 0;
+    trailer_bytes_ = 0;
+    chunked_body_.clear();
+}
+
+// Drop the bytes of requests already taken and shift every offset to match
+void HttpRequestParser::compact() {
+    if (base_ == 0) {
+        return;
+    }
+    size_t base = base_;
+    auto shift = [base](size_t& pos) { pos = pos > base ? pos - base : 0; };
+
+    buffer_.erase(0, base);
+    base_ = 0;
+    shift(scan_pos_);
+    shift(line_start_);
+    shift(method_.pos);
+    shift(target_.pos);
+    shift(version_.pos);
+    for (auto& [name, value] : headers_) {
+        shift(name.pos);
+        shift(value.pos);
+    }
+    shift(body_start_);
+    shift(consumed_);
+}
+
+std::string HttpRequestParser::take_body_data() {
+    std::string data;
+    data.swap(chunked_body_);
+    return data;
+}
+
+std::string HttpRequestParser::error_message() const {
+    switch (error_) {
+        case ErrorType::BadContentLength: return "Invalid Content-Length header";
+        case ErrorType::HeaderTooLarge:   return "Request header too large";
+        case ErrorType::BadTransferEncoding: return "Invalid Transfer-Encoding header";
+        case ErrorType::UnsupportedTransferEncoding: return "Unsupported Transfer-Encoding";
+        case ErrorType::BadChunk:         return "Malformed chunked body";
+        case ErrorType::BodyTooLarge:     return "Request body too large";
+        default:                          return "Malformed HTTP request";
+    }
+}
+
+int HttpRequestParser::error_status_code() const {
+    switch (error_) {
+        case ErrorType::BodyTooLarge:                return 413;
+        case ErrorType::UnsupportedTransferEncoding: return 501;
+        default:                                     return 400;
+    }
+}
+
+std::vector<std::pair<std::string_view, std::string_view>> HttpRequestParser::headers() const {
+    std::vector<std::pair<std::string_view, std::string_view>> result;
+    result.reserve(headers_.size());
+    for (const auto& [name, value] : headers_) {
+        result.emplace_back(view(name), view(value));
+    }
+    return result;
+}
+
+size_t HttpRequestParser::body_received() const {
+    if (state_ != State::Body) {
+        return 0;
+    }
+    if (chunked_) {
+        return chunked_received_;
+    }
+    return buffer_.size() - body_start_;
+}
+
+// Split "METHOD SP target SP version" on runs of spaces or tabs.
+void HttpRequestParser::parse_request_line(size_t line_end) {
+    size_t end = line_end;
+    if (end > line_start_ && buffer_[end - 1] == '\r') {
+        --end;
+    }
+
+    // Blank lines before a request line are ignored (RFC 9112, 2.2).
+    if (end == line_start_) {
+        line_start_ = line_end + 1;
+        return;
+    }
+
+    Span tokens[3];
+    size_t count = 0;
+    size_t i = line_start_;
+    while (i < end) {
+        while (i < end && (buffer_[i] == ' ' || buffer_[i] == '\t')) {
+            ++i;
+        }
+        if (i >= end) {
+            break;
+        }
+        size_t start = i;
+        while (i < end && buffer_[i] != ' ' && buffer_[i] != '\t') {
+            ++i;
+        }
+        if (count < 3) {
+            tokens[count] = Span{start, i - start};
+        }
+        ++count;
+    }
+
+    if (count >= 3) {
+        method_ = tokens[0];
+        target_ = tokens[1];
+        version_ = tokens[2];
+    }
+    if (mode_ == Mode::Strict && count != 3) {
+        fail(ErrorType::BadRequestLine);
+        return;
+    }
+
+    line_start_ = line_end + 1;
+    state_ = State::Headers;
+}
+
+void HttpRequestParser::parse_header_line(size_t line_end) {
+    size_t end = line_end;
+    if (end > line_start_ && buffer_[end - 1] == '\r') {
+        --end;
+    }
+
+    if (end == line_start_) {
+        finish_headers(line_end);
+        return;
+    }
+
+    // Lines without a colon are ignored.
+    size_t colon = std::string_view(buffer_).substr(line_start_, end - line_start_).find(':');
+    if (colon != std::string_view::npos) {
+        colon += line_start_;
+        size_t value_start = colon + 1;
+        size_t value_end = end;
+        while (value_start < value_end &&
+               (buffer_[value_start] == ' ' || buffer_[value_start] == '\t')) {
+            ++value_start;
+        }
+        while (value_end > value_start &&
+               (buffer_[value_end - 1] == ' ' || buffer_[value_end - 1] == '\t' ||
+                buffer_[value_end - 1] == '\r')) {
+            --value_end;
+        }
+        headers_.emplace_back(Span{line_start_, colon - line_start_},
+                              Span{value_start, value_end - value_start});
+    }
+
+    line_start_ = line_end + 1;
+}
+
+void HttpRequestParser::finish_headers(size_t line_end) {
+    crlf_terminated_ = line_end >= base_ + 3 &&
+        buffer_.compare(line_end - 3, 4, "\r\n\r\n") == 0;
+    body_start_ = std::min(line_end + 1, buffer_.size());
+    line_start_ = body_start_;
+
+    if (mode_ == Mode::Lenient) {
+        state_ = State::Body;
+        return;
+    }
+
+    content_length_ = 0;
+    bool has_content_length = false;
+    bool has_transfer_encoding = false;
+    std::string_view transfer_encoding;
+    for (const auto& [name, value] : headers_) {
+        if (iequals(view(name), "Transfer-Encoding")) {
+            // A second one would add codings after the first; with only
+            // "chunked" supported, and chunked allowed once, that is invalid
+            if (has_transfer_encoding) {
+                fail(ErrorType::BadTransferEncoding);
+                return;
+            }
+            transfer_encoding = view(value);
+            has_transfer_encoding = true;
+            continue;
+        }
+        if (!iequals(view(name), "Content-Length")) {
+            continue;
+        }
+        std::string_view digits = view(value);
+        size_t length = 0;
+        auto [ptr, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), length);
+        if (digits.empty() || ec != std::errc() || ptr != digits.data() + digits.size()) {
+            fail(ErrorType::BadContentLength);
+            return;
+        }
+        // Repeats must agree, or the two ends of a proxy could each pick a
+        // different one, just like with Transfer-Encoding below
+        if (has_content_length && length != content_length_) {
+            fail(ErrorType::BadContentLength);
+            return;
+        }
+        content_length_ = length;
+        has_content_length = true;
+    }
+
+    if (has_transfer_encoding) {
+        // Both framings at once is a request smuggling vector (RFC 9112, 6.3)
+        if (has_content_length) {
+            fail(ErrorType::BadTransferEncoding);
+            return;
+        }
+        // Only a bare "chunked" coding is supported
+        if (!iequals(transfer_encoding, "chunked")) {
+            fail(ErrorType::UnsupportedTransferEncoding);
+            return;
+        }
+        chunked_ = true;
+        chunk_state_ = ChunkState::Size;
+        state_ = State::Body;
+        return;
+    }
+
+    if (max_body_bytes_ != 0 && content_length_ > max_body_bytes_) {
+        fail(ErrorType::BodyTooLarge);
+        return;
+    }
+
+    if (content_length_ > 0) {
+        state_ = State::Body;
+    } else {
+        consumed_ = body_start_;
+        state_ = State::Complete;
+    }
+}
+
+// Reject obvious garbage before its request line is complete: the target
+// must start with '/', so anything else after the method is already invalid.
+void HttpRequestParser::check_partial_request_line() {
+    size_t i = line_start_;
+    size_t end = buffer_.size();
+    while (i < end && (buffer_[i] == '\r' || buffer_[i] == ' ' || buffer_[i] == '\t')) {
+        ++i;
+    }
+    while (i < end && buffer_[i] != ' ' && buffer_[i] != '\t') {
+        ++i;
+    }
+    while (i < end && (buffer_[i] == ' ' || buffer_[i] == '\t')) {
+        ++i;
+    }
+    if (i < end && buffer_[i] != '/') {
+        fail(ErrorType::BadRequestLine);
+    }
+}
+
+// Decode as much of a chunked body as the buffer holds. Framing bytes are
+// erased once parsed, so the buffer keeps only the head and the unparsed tail.
+HttpRequestParser::Result HttpRequestParser::advance_chunked() {
+    bool need_more = false;
+    while (state_ == State::Body && !need_more) {
+        switch (chunk_state_) {
+            case ChunkState::Size: {
+                size_t line_end = buffer_.find('\n', scan_pos_);
+                if (line_end == std::string::npos) {
+                    if (buffer_.size() - scan_pos_ > kMaxChunkSizeLine) {
+                        fail(ErrorType::BadChunk);
+                    }
+                    need_more = true;
+                    break;
+                }
+
+                size_t size = 0;
+                size_t digits = 0;
+                size_t i = scan_pos_;
+                for (; i < line_end && std::isxdigit(static_cast<unsigned char>(buffer_[i])); ++i) {
+                    if (++digits > 15) {
+                        fail(ErrorType::BadChunk);
+                        break;
+                    }
+                    char c = buffer_[i];
+                    size = size * 16 + (c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+                }
+                if (state_ == State::Error) {
+                    break;
+                }
+                while (i < line_end && (buffer_[i] == ' ' || buffer_[i] == '\t')) {
+                    ++i;
+                }
+                // Chunk extensions after ';' are ignored
+                if (digits == 0 || (i < line_end && buffer_[i] != ';' && buffer_[i] != '\r')) {
+                    fail(ErrorType::BadChunk);
+                    break;
+                }
+
+                scan_pos_ = line_end + 1;
+                chunk_remaining_ = size;
+                chunk_state_ = size == 0 ? ChunkState::Trailers : ChunkState::Data;
+                break;
+            }
+
+            case ChunkState::Data: {
+                size_t available = std::min(chunk_remaining_, buffer_.size() - scan_pos_);
+                if (available == 0) {
+                    need_more = true;
+                    break;
+                }
+                chunked_body_.append(buffer_, scan_pos_, available);
+                scan_pos_ += available;
+                chunk_remaining_ -= available;
+                chunked_received_ += available;
+                if (max_body_bytes_ != 0 && chunked_received_ > max_body_bytes_) {
+                    fail(ErrorType::BodyTooLarge);
+                    break;
+                }
+                if (chunk_remaining_ == 0) {
+                    chunk_state_ = ChunkState::DataEnd;
+                }
+                break;
+            }
+
+            case ChunkState::DataEnd: {
+                size_t available = buffer_.size() - scan_pos_;
+                if (available == 0 || (buffer_[scan_pos_] == '\r' && available < 2)) {
+                    need_more = true;
+                    break;
+                }
+                if (buffer_[scan_pos_] == '\r') {
+                    ++scan_pos_;
+                }
+                if (buffer_[scan_pos_] != '\n') {
+                    fail(ErrorType::BadChunk);
+                    break;
+                }
+                ++scan_pos_;
+                chunk_state_ = ChunkState::Size;
+                break;
+            }
+
+            case ChunkState::Trailers: {
+                size_t line_end = buffer_.find('\n', scan_pos_);
+                if (line_end == std::string::npos) {
+                    if (trailer_bytes_ + buffer_.size() - scan_pos_ > kMaxHeaderBytes) {
+                        fail(ErrorType::HeaderTooLarge);
+                    }
+                    need_more = true;
+                    break;
+                }
+
+                // Trailer fields are skipped; an empty line ends the body
+                size_t line_length = line_end - scan_pos_;
+                bool empty = line_length == 0 || (line_length == 1 && buffer_[scan_pos_] == '\r');
+                trailer_bytes_ += line_length + 1;
+                scan_pos_ = line_end + 1;
+                if (empty) {
+                    state_ = State::Complete;
+                } else if (trailer_bytes_ > kMaxHeaderBytes) {
+                    fail(ErrorType::HeaderTooLarge);
+                }
+                break;
+            }
+        }
+    }
+
+    if (state_ == State::Error) {
+        return Result::Error;
+    }
+
+    buffer_.erase(body_start_, scan_pos_ - body_start_);
+    scan_pos_ = body_start_;
+    if (state_ == State::Complete) {
+        consumed_ = body_start_;
+    }
+    return result();
+}
+
+HttpRequestParser::Result HttpRequestParser::fail(ErrorType error) {
+    error_ = error;
+    state_ = State::Error;
+    return Result::Error;
+}
+
+HttpRequestParser::Result HttpRequestParser::result() const {
+    switch (state_) {
+        case State::Complete: return Result::Complete;
+        case State::Error:    return Result::Error;
+        default:              return Result::NeedMore;
+    }
+}
@@ -5,8 +5,8 @@ HttpResponse::HttpResponse() :
   version("HTTP/1.1"), message_body(""), headers_map({{"Content-Length", "0"}}) {}
 
 HttpResponse::HttpResponse(const std::string& v, int sc, const std::string& rp, 
-                           const std::map<std::string, std::string>& hm, const std::string& mb) 
-  : version(v), status_code(sc), reason_phrase(rp), headers_map(hm), message_body(mb) {
+                           const std::map<std::string, std::string>& hm, std::string mb) 
+  : version(v), status_code(sc), reason_phrase(rp), headers_map(hm), message_body(std::move(mb)) {
     std::string content_length_str = std::to_string(message_body.size());
     set_header("Content-Length", content_length_str);
 }
@@ -14,30 +14,101 @@ HttpResponse::HttpResponse(const std::string& v, int sc, const std::string& rp,
 
 // Setters
 void HttpResponse::set_version(const std::string& v){
+  unprepare();
   version = v;
 }
 
 void HttpResponse::set_status_code(int sc){
+  unprepare();
   status_code = sc;
 }
 
 void HttpResponse::set_reason_phrase(const std::string& rp){
+  unprepare();
   reason_phrase = rp;
 }
 
 void HttpResponse::set_header(const std::string& k, const std::string& v){
+  unprepare();
   headers_map[k] = v;
 }
 
-void HttpResponse::set_message_body(const std::string& mb){
-  message_body = mb;
+void HttpResponse::remove_header(const std::string& k){
+  unprepare();
+  headers_map.erase(k);
+}
+
+void HttpResponse::set_message_body(std::string mb){
+  unprepare();
+  message_body = std::move(mb);
+  body_stream.reset();
+  headers_map.erase("Transfer-Encoding");
 
   std::string content_length_str = std::to_string(message_body.size());
   set_header("Content-Length", content_length_str);
 }
 
+void HttpResponse::set_body_stream(std::shared_ptr<ResponseBody> body){
+  unprepare();
+  message_body.clear();
+  body_stream = std::move(body);
+
+  std::optional<size_t> size = body_stream ? body_stream->size() : std::optional<size_t>(0);
+  if (size) {
+    headers_map.erase("Transfer-Encoding");
+    set_header("Content-Length", std::to_string(*size));
+  } else {
+    headers_map.erase("Content-Length");
+    set_header("Transfer-Encoding", "chunked");
+  }
+}
+
+void HttpResponse::set_prepared(int sc, std::shared_ptr<const std::string> head,
+                                std::shared_ptr<const std::string> body){
+  status_code = sc;
+  prepared_head = std::move(head);
+  prepared_body = std::move(body);
+  headers_map.clear();
+  message_body.clear();
+  body_stream.reset();
+}
+
+void HttpResponse::unprepare(){
+  if (!prepared_head) {
+    return;
+  }
+  std::shared_ptr<const std::string> head = std::move(prepared_head);
+  std::shared_ptr<const std::string> body = std::move(prepared_body);
+
+  // "<version> <code> <reason>\r\n" then "<name>: <value>\r\n" lines
+  size_t line_end = head->find("\r\n");
+  std::string status_line = head->substr(0, line_end);
+  size_t first_space = status_line.find(' ');
+  size_t second_space = status_line.find(' ', first_space + 1);
+  version = status_line.substr(0, first_space);
+  reason_phrase = second_space == std::string::npos ? "" : status_line.substr(second_space + 1);
+
+  headers_map.clear();
+  size_t start = line_end + 2;
+  while (start < head->size()) {
+    size_t end = head->find("\r\n", start);
+    if (end == std::string::npos || end == start) {
+      break;
+    }
+    size_t colon = head->find(": ", start);
+    if (colon != std::string::npos && colon < end) {
+      headers_map[head->substr(start, colon - start)] = head->substr(colon + 2, end - colon - 2);
+    }
+    start = end + 2;
+  }
+  message_body = body ? *body : "";
+}
+
 //Getters
 std::string HttpResponse::get_version() const {
+  if (prepared_head) {
+    return prepared_head->substr(0, prepared_head->find(' '));
+  }
   return version;
 }
 
@@ -46,10 +117,23 @@ int HttpResponse::get_status_code() const {
 }
 
 std::string HttpResponse::get_reason_phrase() const {
+  if (prepared_head) {
+    size_t start = prepared_head->find(' ', prepared_head->find(' ') + 1) + 1;
+    return prepared_head->substr(start, prepared_head->find("\r\n") - start);
+  }
   return reason_phrase;
 }
 
 std::string HttpResponse::get_header(const std::string& header_name) const {
+  if (prepared_head) {
+    std::string key = "\r\n" + header_name + ": ";
+    size_t start = prepared_head->find(key);
+    if (start == std::string::npos) {
+      return "";
+    }
+    start += key.size();
+    return prepared_head->substr(start, prepared_head->find("\r\n", start) - start);
+  }
   auto it = headers_map.find(header_name);
   if (it != headers_map.end()) {
       return it->second;
@@ -57,29 +141,65 @@ std::string HttpResponse::get_header(const std::string& header_name) const {
   return "";
 }
 
-std::string HttpResponse::get_message_body() const {
+const std::string& HttpResponse::get_message_body() const {
+  if (prepared_body) {
+    return *prepared_body;
+  }
   return message_body;
 }
 
+const std::shared_ptr<ResponseBody>& HttpResponse::get_body_stream() const {
+  return body_stream;
+}
+
 //Methods
 std::string HttpResponse::convert_to_string() const{
 
+  std::string response_string = serialize_head();
+  response_string += get_message_body();
+  return response_string;
+
+}
+
+std::string HttpResponse::serialize_head() const{
+
+  if (prepared_head) {
+    return *prepared_head;
+  }
+
+  // Size the string up front so the head is built with one allocation
+  std::string status_code_str = std::to_string(status_code);
+  size_t size = version.size() + 1 + status_code_str.size() + 1 + reason_phrase.size() + 2;
+  for (auto const& [header_name, header_value] : headers_map) {
+    size += header_name.size() + 2 + header_value.size() + 2;
+  }
+  size += 2;
+
+  std::string head;
+  head.reserve(size);
+
   // Construct the Status line 
-  std::string status_line = version + " " + std::to_string(status_code)
-                                    + " " + reason_phrase + "\r\n";
+  head.append(version).append(" ").append(status_code_str)
+      .append(" ").append(reason_phrase).append("\r\n");
 
   // Construct the Header lines
-  std::string headers_str = "";
   for (auto const& [header_name, header_value] : headers_map) {
-    headers_str += header_name + ": " + header_value + "\r\n";
+    head.append(header_name).append(": ").append(header_value).append("\r\n");
   }
 
-  // Put it all together
-  std::string response_string = status_line +
-                                headers_str + 
-                                "\r\n" +
-                                message_body; 
+  head.append("\r\n");
+  return head;
 
-  return response_string;
+}
+
+std::vector<boost::asio::const_buffer> HttpResponse::to_buffers(const std::string& head) const{
+
+  std::vector<boost::asio::const_buffer> buffers;
+  buffers.push_back(boost::asio::buffer(prepared_head ? *prepared_head : head));
+  const std::string& body = get_message_body();
+  if (!body.empty()) {
+    buffers.push_back(boost::asio::buffer(body));
+  }
+  return buffers;
 
 }
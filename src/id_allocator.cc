@@ -0,0 +1,151 @@
+#include "id_allocator.h"
+
+#include <stdexcept>
+
+// Only the canonical form counts: "07" is a different ID from "7", so it
+// must not take 7 out of circulation
+std::optional<uint64_t> IdAllocator::parse(const std::string& id) {
+    if (id.empty() || id.size() > 10 || id[0] == '0') {
+        return std::nullopt;
+    }
+    uint64_t value = 0;
+    for (char c : id) {
+        if (c < '0' || c > '9') {
+            return std::nullopt;
+        }
+        value = value * 10 + static_cast<uint64_t>(c - '0');
+    }
+    if (value > kMaxId) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+std::string IdAllocator::allocate() {
+    uint64_t id;
+    if (!reuse_) {
+        id = next_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_.empty()) {
+            auto first = free_.begin();
+            id = first->first;
+            if (first->second > id) {
+                free_.emplace_hint(std::next(first), id + 1, first->second);
+            }
+            free_.erase(first);
+            return std::to_string(id);
+        }
+        id = next_.load(std::memory_order_relaxed);
+        next_.store(id + 1, std::memory_order_relaxed);
+    }
+
+    if (id > kMaxId) {
+        throw std::overflow_error("IdAllocator: no available integer IDs");
+    }
+    return std::to_string(id);
+}
+
+void IdAllocator::claim(const std::string& id) {
+    std::optional<uint64_t> value = parse(id);
+    if (!value) {
+        return;
+    }
+    if (!reuse_) {
+        uint64_t next = next_.load(std::memory_order_relaxed);
+        while (next <= *value && !next_.compare_exchange_weak(next, *value + 1, std::memory_order_relaxed)) {
+        }
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    claim_locked(*value);
+}
+
+// Caller holds mutex_
+void IdAllocator::claim_locked(uint64_t id) {
+    uint64_t next = next_.load(std::memory_order_relaxed);
+    if (id >= next) {
+        // The IDs jumped over are free, joining a free range that ends
+        // right below them
+        if (id > next) {
+            if (!free_.empty() && std::prev(free_.end())->second + 1 == next) {
+                std::prev(free_.end())->second = id - 1;
+            } else {
+                free_.emplace_hint(free_.end(), next, id - 1);
+            }
+        }
+        next_.store(id + 1, std::memory_order_relaxed);
+        return;
+    }
+
+    // Take id out of the free range holding it, if any
+    auto range = free_.upper_bound(id);
+    if (range == free_.begin()) {
+        return;
+    }
+    --range;
+    uint64_t first = range->first;
+    uint64_t last = range->second;
+    if (last < id) {
+        return;
+    }
+    free_.erase(range);
+    if (first < id) {
+        free_.emplace(first, id - 1);
+    }
+    if (id < last) {
+        free_.emplace(id + 1, last);
+    }
+}
+
+void IdAllocator::release(const std::string& id) {
+    std::optional<uint64_t> value = parse(id);
+    if (!reuse_ || !value) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (*value >= next_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    uint64_t first = *value;
+    uint64_t last = *value;
+    auto after = free_.upper_bound(*value);
+    if (after != free_.begin()) {
+        auto before = std::prev(after);
+        if (before->second >= *value) {
+            return;  // already free
+        }
+        if (before->second + 1 == *value) {
+            first = before->first;
+            free_.erase(before);
+        }
+    }
+    if (after != free_.end() && after->first == *value + 1) {
+        last = after->second;
+        free_.erase(after);
+    }
+    free_.emplace(first, last);
+}
+
+IdAllocator& IdAllocators::get(const std::string& entity) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = allocators_.find(entity);
+        if (it != allocators_.end()) {
+            return *it->second;
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    std::unique_ptr<IdAllocator>& allocator = allocators_[entity];
+    if (!allocator) {
+        allocator = std::make_unique<IdAllocator>(reuse_);
+    }
+    return *allocator;
+}
+
+void IdAllocators::clear() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    allocators_.clear();
+}
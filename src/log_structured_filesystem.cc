@@ -0,0 +1,390 @@
+#include "log_structured_filesystem.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+
+#include <boost/crc.hpp>
+#include <boost/log/trivial.hpp>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// checksum, type, entity size, id size, value size; the checksum covers
+// everything after itself, names and value included
+constexpr size_t kHeaderSize = 4 + 1 + 4 + 4 + 4;
+
+constexpr char kSegmentPrefix[] = "segment-";
+constexpr char kSegmentSuffix[] = ".log";
+
+void put_u32(char* out, uint32_t value) {
+    std::memcpy(out, &value, sizeof(value));
+}
+
+uint32_t get_u32(const char* in) {
+    uint32_t value;
+    std::memcpy(&value, in, sizeof(value));
+    return value;
+}
+
+uint32_t checksum(const char* data, size_t size) {
+    boost::crc_32_type crc;
+    crc.process_bytes(data, size);
+    return crc.checksum();
+}
+
+// The number in "segment-<number>.log", or 0 for any other name
+uint64_t segment_number(const std::string& name) {
+    size_t prefix = sizeof(kSegmentPrefix) - 1;
+    size_t suffix = sizeof(kSegmentSuffix) - 1;
+    if (name.size() <= prefix + suffix || name.compare(0, prefix, kSegmentPrefix) != 0 ||
+        name.compare(name.size() - suffix, suffix, kSegmentSuffix) != 0) {
+        return 0;
+    }
+    uint64_t number = 0;
+    for (size_t i = prefix; i < name.size() - suffix; ++i) {
+        if (name[i] < '0' || name[i] > '9') {
+            return 0;
+        }
+        number = number * 10 + static_cast<uint64_t>(name[i] - '0');
+    }
+    return number;
+}
+
+bool pread_all(int fd, char* data, size_t size, uint64_t offset) {
+    while (size > 0) {
+        ssize_t n = ::pread(fd, data, size, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+bool pwrite_all(int fd, const char* data, size_t size, uint64_t offset) {
+    while (size > 0) {
+        ssize_t n = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+}
+
+LogStructuredFilesystem::LogStructuredFilesystem(const std::string& root)
+    : LogStructuredFilesystem(root, Options()) {}
+
+LogStructuredFilesystem::LogStructuredFilesystem(const std::string& root, Options options)
+    : root_(root), options_(options), ids_(options.reuse_ids) {
+    try {
+        open_segments();
+    } catch (...) {
+        for (const Segment& segment : segments_) {
+            ::close(segment.fd);
+        }
+        throw;
+    }
+}
+
+LogStructuredFilesystem::~LogStructuredFilesystem() {
+    for (const Segment& segment : segments_) {
+        ::close(segment.fd);
+    }
+}
+
+std::string LogStructuredFilesystem::segment_path(uint64_t number) const {
+    char name[64];
+    snprintf(name, sizeof(name), "%s%06llu%s", kSegmentPrefix,
+             static_cast<unsigned long long>(number), kSegmentSuffix);
+    return (std::filesystem::path(root_) / name).string();
+}
+
+void LogStructuredFilesystem::open_segments() {
+    std::filesystem::create_directories(root_);
+
+    std::vector<uint64_t> numbers;
+    for (const auto& file : std::filesystem::directory_iterator(root_)) {
+        uint64_t number = segment_number(file.path().filename().string());
+        if (number > 0 && file.is_regular_file()) {
+            numbers.push_back(number);
+        }
+    }
+    std::sort(numbers.begin(), numbers.end());
+
+    for (size_t i = 0; i < numbers.size(); ++i) {
+        open_segment(numbers[i], false);
+        replay(segments_.size() - 1, i + 1 == numbers.size());
+    }
+    if (segments_.empty()) {
+        open_segment(1, true);
+    }
+
+    BOOST_LOG_TRIVIAL(info) << "LogStructuredFilesystem: Opened " << root_ << " with "
+                            << segments_.size() << " segment(s)";
+}
+
+void LogStructuredFilesystem::open_segment(uint64_t number, bool create) {
+    std::string path = segment_path(number);
+    int flags = O_RDWR | O_CLOEXEC | (create ? O_CREAT | O_EXCL : 0);
+    int fd = ::open(path.c_str(), flags, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("LogStructuredFilesystem: Could not open " + path + ": " +
+                                 std::strerror(errno));
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        int error = errno;
+        ::close(fd);
+        throw std::runtime_error("LogStructuredFilesystem: Could not stat " + path + ": " +
+                                 std::strerror(error));
+    }
+    segments_.push_back(Segment{number, fd, static_cast<uint64_t>(st.st_size)});
+
+    // The new name must be durable too, or the segment can vanish with the
+    // records synced into it
+    if (create && options_.sync) {
+        int dir = ::open(root_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dir >= 0) {
+            ::fsync(dir);
+            ::close(dir);
+        }
+    }
+}
+
+// Rebuilds the index from one segment. Only the last segment can end in a
+// torn append, so it is cut off at the first record that is incomplete or
+// corrupt. A bad record in a sealed segment is damage to data that was
+// complete, and later segments may depend on it, so opening fails instead
+// of throwing away the rest of that segment.
+void LogStructuredFilesystem::replay(size_t segment, bool last) {
+    Segment& file = segments_[segment];
+    std::string contents(file.size, '\0');
+    if (!pread_all(file.fd, &contents[0], contents.size(), 0)) {
+        throw std::runtime_error("LogStructuredFilesystem: Could not read " + segment_path(file.number));
+    }
+
+    uint64_t offset = 0;
+    while (offset + kHeaderSize <= contents.size()) {
+        const char* header = contents.data() + offset;
+        uint8_t type = static_cast<uint8_t>(header[4]);
+        uint64_t entity_size = get_u32(header + 5);
+        uint64_t id_size = get_u32(header + 9);
+        uint64_t value_size = get_u32(header + 13);
+        uint64_t record_size = kHeaderSize + entity_size + id_size + value_size;
+        if (offset + record_size > contents.size() ||
+            (type != kPut && type != kDelete) ||
+            get_u32(header) != checksum(header + 4, record_size - 4)) {
+            break;
+        }
+
+        std::string entity(header + kHeaderSize, entity_size);
+        std::string id(header + kHeaderSize + entity_size, id_size);
+        Location location{segment, offset + kHeaderSize + entity_size + id_size,
+                          static_cast<uint32_t>(value_size), record_size};
+        apply(static_cast<RecordType>(type), entity, id, location);
+        offset += record_size;
+    }
+
+    if (offset < contents.size() && !last) {
+        throw std::runtime_error("LogStructuredFilesystem: Damaged record at offset " +
+                                 std::to_string(offset) + " of sealed segment " +
+                                 segment_path(file.number));
+    }
+    if (offset < contents.size()) {
+        BOOST_LOG_TRIVIAL(warning) << "LogStructuredFilesystem: Dropping " << contents.size() - offset
+                                   << " damaged byte(s) at the end of " << segment_path(file.number);
+        if (::ftruncate(file.fd, static_cast<off_t>(offset)) != 0) {
+            throw std::runtime_error("LogStructuredFilesystem: Could not truncate " +
+                                     segment_path(file.number) + ": " + std::strerror(errno));
+        }
+        file.size = offset;
+    }
+}
+
+void LogStructuredFilesystem::apply(RecordType type, const std::string& entity, const std::string& id,
+                                    const Location& location) {
+    IdIndex& ids = index_[entity];
+    auto it = ids.find(id);
+    IdAllocator& allocator = ids_.get(entity);
+    if (it != ids.end()) {
+        dead_bytes_ += it->second.record_size;
+    }
+
+    if (type == kDelete) {
+        // The tombstone itself is only needed while older records exist
+        dead_bytes_ += location.record_size;
+        if (it != ids.end()) {
+            ids.erase(it);
+        }
+        allocator.release(id);
+        return;
+    }
+    allocator.claim(id);
+    if (it != ids.end()) {
+        it->second = location;
+    } else {
+        ids.emplace(id, location);
+    }
+}
+
+bool LogStructuredFilesystem::append(RecordType type, const std::string& entity, const std::string& id,
+                                     const std::string& value, Location& location) {
+    constexpr uint64_t kMaxField = std::numeric_limits<uint32_t>::max();
+    if (entity.size() > kMaxField || id.size() > kMaxField || value.size() > kMaxField) {
+        return false;
+    }
+
+    if (segments_.back().size >= options_.segment_bytes) {
+        try {
+            open_segment(segments_.back().number + 1, true);
+        } catch (const std::runtime_error& e) {
+            BOOST_LOG_TRIVIAL(error) << e.what();
+            return false;
+        }
+    }
+
+    std::string record(kHeaderSize, '\0');
+    record.reserve(kHeaderSize + entity.size() + id.size() + value.size());
+    record[4] = static_cast<char>(type);
+    put_u32(&record[5], static_cast<uint32_t>(entity.size()));
+    put_u32(&record[9], static_cast<uint32_t>(id.size()));
+    put_u32(&record[13], static_cast<uint32_t>(value.size()));
+    record += entity;
+    record += id;
+    record += value;
+    put_u32(&record[0], checksum(record.data() + 4, record.size() - 4));
+
+    Segment& segment = segments_.back();
+    if (!pwrite_all(segment.fd, record.data(), record.size(), segment.size) ||
+        (options_.sync && ::fdatasync(segment.fd) != 0)) {
+        BOOST_LOG_TRIVIAL(error) << "LogStructuredFilesystem: Could not append to "
+                                 << segment_path(segment.number) << ": " << std::strerror(errno);
+        // Whatever made it to the file would be replayed as a write that
+        // failed
+        int ignored = ::ftruncate(segment.fd, static_cast<off_t>(segment.size));
+        (void)ignored;
+        return false;
+    }
+
+    location = Location{segments_.size() - 1, segment.size + kHeaderSize + entity.size() + id.size(),
+                        static_cast<uint32_t>(value.size()), record.size()};
+    segment.size += record.size();
+    return true;
+}
+
+bool LogStructuredFilesystem::entity_exists(const Entity& entity, const std::string& id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto eit = index_.find(entity.name);
+    return eit != index_.end() && eit->second.count(id) > 0;
+}
+
+bool LogStructuredFilesystem::write_entity(const Entity& entity, const std::string& id, const std::string& data) {
+    BOOST_LOG_TRIVIAL(debug) << "LogStructuredFilesystem: Writing entity " << entity.make_name(id);
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    Location location;
+    if (!append(kPut, entity.name, id, data, location)) {
+        return false;
+    }
+    apply(kPut, entity.name, id, location);
+    return true;
+}
+
+std::string LogStructuredFilesystem::read_entity(const Entity& entity, const std::string& id) const {
+    int fd = -1;
+    Location location;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto eit = index_.find(entity.name);
+        if (eit != index_.end()) {
+            auto it = eit->second.find(id);
+            if (it != eit->second.end()) {
+                location = it->second;
+                fd = segments_[location.segment].fd;
+            }
+        }
+    }
+    if (fd < 0) {
+        BOOST_LOG_TRIVIAL(warning)
+            << "LogStructuredFilesystem: No such entity or ID: " << entity.make_name(id);
+        throw std::runtime_error(
+            "LogStructuredFilesystem: No such entity or ID: " + entity.make_name(id));
+    }
+
+    // Records are never rewritten in place, so the value is still there
+    // even if it has been replaced since
+    std::string value(location.length, '\0');
+    if (!pread_all(fd, &value[0], value.size(), location.offset)) {
+        throw std::runtime_error("LogStructuredFilesystem: Could not read " + entity.make_name(id) +
+                                 ": " + std::strerror(errno));
+    }
+    return value;
+}
+
+bool LogStructuredFilesystem::delete_entity(const Entity& entity, const std::string& id) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto eit = index_.find(entity.name);
+    if (eit == index_.end() || !eit->second.count(id)) {
+        BOOST_LOG_TRIVIAL(warning)
+            << "LogStructuredFilesystem: Could not remove entity (no such entity or id): "
+            << entity.make_name(id);
+        return false;
+    }
+
+    BOOST_LOG_TRIVIAL(debug) << "LogStructuredFilesystem: Removing entity " << entity.make_name(id);
+    Location location;
+    if (!append(kDelete, entity.name, id, "", location)) {
+        return false;
+    }
+    apply(kDelete, entity.name, id, location);
+    return true;
+}
+
+std::vector<std::string> LogStructuredFilesystem::list_entity_ids(const Entity& entity) const {
+    std::vector<std::string> ids;
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto eit = index_.find(entity.name);
+    if (eit == index_.end()) {
+        return ids;
+    }
+    ids.reserve(eit->second.size());
+    for (const auto& [id, _] : eit->second) {
+        ids.push_back(id);
+    }
+    return ids;
+}
+
+std::string LogStructuredFilesystem::next_entity_id(const Entity& entity) const {
+    return ids_.get(entity.name).allocate();
+}
+
+size_t LogStructuredFilesystem::segments() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return segments_.size();
+}
+
+uint64_t LogStructuredFilesystem::dead_bytes() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return dead_bytes_;
+}
@@ -0,0 +1,96 @@
+#include "mapped_file.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iterator>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+std::shared_ptr<const MappedFile> MappedFile::map(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open " + path + ": " + std::strerror(errno));
+    }
+    try {
+        std::shared_ptr<const MappedFile> mapped = map(fd, path);
+        ::close(fd);
+        return mapped;
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+}
+
+std::shared_ptr<const MappedFile> MappedFile::map(int fd, const std::string& name) {
+    struct stat file_stat;
+    if (::fstat(fd, &file_stat) != 0) {
+        throw std::runtime_error("Could not stat " + name + ": " + std::strerror(errno));
+    }
+
+    std::shared_ptr<MappedFile> mapped(new MappedFile());
+    mapped->size_ = static_cast<size_t>(file_stat.st_size);
+    mapped->inode_ = file_stat.st_ino;
+    mapped->mtime_ns_ = static_cast<int64_t>(file_stat.st_mtim.tv_sec) * 1000000000 + file_stat.st_mtim.tv_nsec;
+
+    // mmap() refuses empty mappings; an empty file simply has no data
+    if (mapped->size_ > 0) {
+        void* data = ::mmap(nullptr, mapped->size_, PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            throw std::runtime_error("Could not map " + name + ": " + std::strerror(errno));
+        }
+        // Responses read front to back
+        ::madvise(data, mapped->size_, MADV_SEQUENTIAL);
+        mapped->data_ = static_cast<const char*>(data);
+    }
+
+    // The mapping keeps the file alive on its own
+    return mapped;
+}
+
+MappedFile::~MappedFile() {
+    if (data_) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+std::shared_ptr<const MappedFile> MappingCache::acquire(const std::string& path, uint64_t inode,
+                                                        uint64_t size, int64_t mtime_ns) {
+    return acquire(path, -1, inode, size, mtime_ns);
+}
+
+std::shared_ptr<const MappedFile> MappingCache::acquire(const std::string& path, int fd, uint64_t inode,
+                                                        uint64_t size, int64_t mtime_ns) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = mappings_.find(path);
+    if (it != mappings_.end()) {
+        std::shared_ptr<const MappedFile> mapped = it->second.lock();
+        if (mapped && mapped->inode() == inode && mapped->size() == size && mapped->mtime_ns() == mtime_ns) {
+            return mapped;
+        }
+    }
+
+    // Mapping under the lock lets concurrent first requests share one
+    // mapping; mmap() itself reads nothing
+    std::shared_ptr<const MappedFile> mapped = fd >= 0 ? MappedFile::map(fd, path) : MappedFile::map(path);
+
+    // Forget files nobody is serving any more, so the table stays as small
+    // as the set of mappings in use
+    for (auto entry = mappings_.begin(); entry != mappings_.end();) {
+        entry = entry->second.expired() ? mappings_.erase(entry) : std::next(entry);
+    }
+    mappings_[path] = mapped;
+    return mapped;
+}
+
+size_t MappingCache::mapped_files() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t live = 0;
+    for (const auto& [path, mapping] : mappings_) {
+        if (!mapping.expired()) {
+            ++live;
+        }
+    }
+    return live;
+}
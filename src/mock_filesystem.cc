@@ -1,16 +1,23 @@
 #include "mock_filesystem.h"
 
 #include <algorithm>
-#include <stdexcept>
-#include <limits>
-#include <unordered_set>
+#include <functional>
+#include <mutex>
 #include <stdexcept>
 
 #include <boost/log/trivial.hpp>
 
+MockFilesystem::Shard& MockFilesystem::shard_for(const Entity& entity, const std::string& id) const {
+    std::hash<std::string> hash;
+    size_t h = hash(entity.name) * 31 + hash(id);
+    return shards_[h % kShards];
+}
+
 bool MockFilesystem::entity_exists(const Entity& entity, const std::string& id) const {
-    auto eit = data_.find(entity.name);
-    if (eit == data_.end()) {
+    Shard& shard = shard_for(entity, id);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto eit = shard.data.find(entity.name);
+    if (eit == shard.data.end()) {
         return false;
     }
     return eit->second.find(id) != eit->second.end();
@@ -18,27 +25,38 @@ bool MockFilesystem::entity_exists(const Entity& entity, const std::string& id)
 
 bool MockFilesystem::write_entity(const Entity& entity, const std::string& id, const std::string& data) {
     BOOST_LOG_TRIVIAL(debug) << "MockFilesystem: Writing entity " << entity.make_name(id);
-    data_[entity.name][id] = data;
+    Shard& shard = shard_for(entity, id);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    shard.data[entity.name][id] = data;
+    ids_.get(entity.name).claim(id);
     return true;
 }
 
 std::string MockFilesystem::read_entity(const Entity& entity, const std::string& id) const {
-    if (!entity_exists(entity, id)) {
-        BOOST_LOG_TRIVIAL(warning)
-            << "MockFilesystem: No such entity or ID: " << entity.make_name(id);
-
-        throw std::runtime_error(
-            "MockFilesystem: No such entity or ID: " + entity.make_name(id));
+    {
+        Shard& shard = shard_for(entity, id);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto eit = shard.data.find(entity.name);
+        if (eit != shard.data.end()) {
+            auto it = eit->second.find(id);
+            if (it != eit->second.end()) {
+                return it->second;
+            }
+        }
     }
 
-    const auto& entity_map = data_.at(entity.name);
-    const auto& value = entity_map.at(id);
-    return value;
+    BOOST_LOG_TRIVIAL(warning)
+        << "MockFilesystem: No such entity or ID: " << entity.make_name(id);
+
+    throw std::runtime_error(
+        "MockFilesystem: No such entity or ID: " + entity.make_name(id));
 }
 
 bool MockFilesystem::delete_entity(const Entity& entity, const std::string& id) {
-    auto eit = data_.find(entity.name);
-    if (eit == data_.end()) {
+    Shard& shard = shard_for(entity, id);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto eit = shard.data.find(entity.name);
+    if (eit == shard.data.end()) {
         BOOST_LOG_TRIVIAL(warning)
             << "MockFilesystem: Could not remove entity (no such type): "
             << entity.make_name(id);
@@ -57,66 +75,39 @@ bool MockFilesystem::delete_entity(const Entity& entity, const std::string& id)
         << "MockFilesystem: Removing entity " << entity.make_name(id);
 
     eit->second.erase(it);
+    ids_.get(entity.name).release(id);
     return true;
 }
 
 std::vector<std::string> MockFilesystem::list_entity_ids(const Entity& entity) const {
     std::vector<std::string> ids;
 
-    auto eit = data_.find(entity.name);
-    if (eit == data_.end()) {
-        return ids;  // no such entity type yet
-    }
-
-    ids.reserve(eit->second.size());
-    for (const auto& [id, _] : eit->second) {
-        ids.push_back(id);
+    for (Shard& shard : shards_) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto eit = shard.data.find(entity.name);
+        if (eit == shard.data.end()) {
+            continue;  // no such entity type in this shard
+        }
+        ids.reserve(ids.size() + eit->second.size());
+        for (const auto& [id, _] : eit->second) {
+            ids.push_back(id);
+        }
     }
     return ids;
 }
 
 std::string MockFilesystem::next_entity_id(const Entity& entity) const {
-    auto ids = list_entity_ids(entity);
-    std::unordered_set<int> used_ids;
-    used_ids.reserve(ids.size());
-
-    for (const auto& id_str : ids) {
-        try {
-            int id = std::stoi(id_str);
-            if (id > 0) {
-                used_ids.insert(id);
-            }
-        } catch (const std::invalid_argument&) {
-            // Non-numeric ID, ignore
-        } catch (const std::out_of_range&) {
-            // Too big to be an int, ignore
-        }
-    }
-
-     // Find the smallest positive integer not in used_ids.
-    int candidate = 1;
-    while (true) {
-        if (used_ids.find(candidate) == used_ids.end()) {
-            BOOST_LOG_TRIVIAL(debug)
-                << "MockFilesystem: next_entity_id for " << entity.name
-                << " -> " << candidate;
-            return std::to_string(candidate);
-        }
-
-        if (candidate == std::numeric_limits<int>::max()) {
-            BOOST_LOG_TRIVIAL(error)
-                << "MockFilesystem: next_entity_id overflow for entity "
-                << entity.name;
-            throw std::overflow_error(
-                "MockFilesystem: no available integer IDs for entity " +
-                entity.name);
-        }
-
-        ++candidate;
-    }
+    std::string id = ids_.get(entity.name).allocate();
+    BOOST_LOG_TRIVIAL(debug)
+        << "MockFilesystem: next_entity_id for " << entity.name << " -> " << id;
+    return id;
 }
 
 void MockFilesystem::reset() {
     BOOST_LOG_TRIVIAL(debug) << "MockFilesystem: Resetting";
-    data_.clear();
+    for (Shard& shard : shards_) {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.data.clear();
+    }
+    ids_.clear();
 }
@@ -3,30 +3,34 @@
 #include "echo_handler.h"
 #include "file_handler.h"
 #include "server_config.h"
+#include "logger.h"
 #include <sstream>
+#include <stdexcept>
 
-PathRouter::PathRouter(const ServerConfig& config) 
-    : routes_(config.get_routes()) {}
+PathRouter::PathRouter(const ServerConfig& config) {
+    HandlerConfig not_found_config;
+    not_found_config.type = "NotFoundHandler";
+    not_found_handler_ = handler_factory_.create_handler(not_found_config, "");
 
-std::unique_ptr<RequestHandler> PathRouter::match_handler(const std::string& path) const {
-    std::string prefix_match = "";
-    int max_len = 0;
-    
-    for (const auto& [route_path, handler_config] : routes_) {
-        if (path.rfind(route_path, 0) == 0) {
-            if (route_path.length() > max_len) {
-                max_len = route_path.length();
-                prefix_match = route_path;
-            }
+    for (const auto& [route_path, handler_config] : config.get_routes()) {
+        std::shared_ptr<RequestHandler> handler;
+        try {
+            handler = handler_factory_.create_handler(handler_config, route_path);
+        } catch (const std::exception& e) {
+            // A bad location (e.g. a missing root) must not take the server down
+            Logger::getLogger()->logErrorFile("Failed to create " + handler_config.type +
+                                              " for location '" + route_path + "': " + e.what());
         }
+        routes_.insert(route_path, handler ? handler : not_found_handler_);
     }
-    if (!prefix_match.empty()){
-        const auto& handler = routes_.at(prefix_match);
-        return handler_factory_.create_handler(handler, prefix_match);
+}
+
+std::shared_ptr<RequestHandler> PathRouter::match_handler(const std::string& path) const {
+    std::shared_ptr<RequestHandler> handler = routes_.match(path);
+    if (handler) {
+        return handler;
     }
 
     // Default fallback
-    HandlerConfig not_found_config;
-    not_found_config.type = "NotFoundHandler";
-    return handler_factory_.create_handler(not_found_config, path);
+    return not_found_handler_;
 }
@@ -0,0 +1,156 @@
+#include "response_body.h"
+#include "mapped_file.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/sendfile.h>
+#include <unistd.h>
+
+FileBody::FileBody(const std::string& path, size_t offset, size_t length)
+    : offset_(offset), length_(length) {
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        throw std::runtime_error("Could not open " + path + ": " + std::strerror(errno));
+    }
+}
+
+FileBody::FileBody(int fd, size_t offset, size_t length)
+    : fd_(fd), offset_(offset), length_(length) {
+    if (fd_ < 0) {
+        throw std::runtime_error(std::string("Invalid file descriptor: ") + std::strerror(errno));
+    }
+}
+
+FileBody::~FileBody() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+size_t FileBody::read(char* data, size_t capacity) {
+    size_t wanted = std::min(capacity, length_ - position_);
+    if (wanted == 0) {
+        return 0;
+    }
+
+    ssize_t n;
+    do {
+        n = ::pread(fd_, data, wanted, static_cast<off_t>(offset_ + position_));
+    } while (n < 0 && errno == EINTR);
+
+    // The Content-Length is already on the wire, so a short file is an error
+    if (n <= 0) {
+        throw std::runtime_error(n == 0 ? "File shrank while being sent"
+                                        : std::string("Read failed: ") + std::strerror(errno));
+    }
+    position_ += static_cast<size_t>(n);
+    return static_cast<size_t>(n);
+}
+
+size_t FileBody::send_to(int socket_fd, size_t max_bytes, bool& would_block) {
+    would_block = false;
+    size_t wanted = std::min(max_bytes, length_ - position_);
+    if (wanted == 0) {
+        return 0;
+    }
+
+    off_t offset = static_cast<off_t>(offset_ + position_);
+    ssize_t n;
+    do {
+        n = ::sendfile(socket_fd, fd_, &offset, wanted);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        would_block = true;
+        return 0;
+    }
+    if (n <= 0) {
+        throw std::runtime_error(n == 0 ? "File shrank while being sent"
+                                        : std::string("sendfile failed: ") + std::strerror(errno));
+    }
+    position_ += static_cast<size_t>(n);
+    return static_cast<size_t>(n);
+}
+
+MappedBody::MappedBody(std::shared_ptr<const MappedFile> file, size_t offset, size_t length)
+    : file_(std::move(file)), offset_(offset), length_(length) {
+    // The file may have shrunk between the caller's stat and the mapping
+    if (offset_ > file_->size() || length_ > file_->size() - offset_) {
+        throw std::runtime_error("Range lies outside the mapped file");
+    }
+}
+
+size_t MappedBody::read(char* data, size_t capacity) {
+    std::string_view span = next_span(capacity);
+    std::memcpy(data, span.data(), span.size());
+    return span.size();
+}
+
+std::string_view MappedBody::next_span(size_t max_bytes) {
+    size_t n = std::min(max_bytes, length_ - position_);
+    std::string_view span(file_->data() + offset_ + position_, n);
+    position_ += n;
+    return span;
+}
+
+GeneratorBody::GeneratorBody(Generator generator)
+    : generator_(std::move(generator)) {}
+
+size_t GeneratorBody::read(char* data, size_t capacity) {
+    // Skip empty pieces; they would look like the end of the body
+    while (pending_pos_ == pending_.size()) {
+        if (done_) {
+            return 0;
+        }
+        std::optional<std::string> piece = generator_();
+        if (!piece) {
+            done_ = true;
+            return 0;
+        }
+        pending_ = std::move(*piece);
+        pending_pos_ = 0;
+    }
+
+    size_t n = std::min(capacity, pending_.size() - pending_pos_);
+    std::memcpy(data, pending_.data() + pending_pos_, n);
+    pending_pos_ += n;
+    return n;
+}
+
+StringBody::StringBody(std::string data) : data_(std::move(data)) {}
+
+size_t StringBody::read(char* data, size_t capacity) {
+    size_t n = std::min(capacity, data_.size() - position_);
+    std::memcpy(data, data_.data() + position_, n);
+    position_ += n;
+    return n;
+}
+
+void CompositeBody::append(std::shared_ptr<ResponseBody> part) {
+    parts_.push_back(std::move(part));
+}
+
+std::optional<size_t> CompositeBody::size() const {
+    size_t total = 0;
+    for (const auto& part : parts_) {
+        std::optional<size_t> part_size = part->size();
+        if (!part_size) {
+            return std::nullopt;
+        }
+        total += *part_size;
+    }
+    return total;
+}
+
+size_t CompositeBody::read(char* data, size_t capacity) {
+    while (current_ < parts_.size()) {
+        size_t n = parts_[current_]->read(data, capacity);
+        if (n > 0) {
+            return n;
+        }
+        ++current_;
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include "route_trie.h"
+#include <algorithm>
+
+namespace {
+
+bool is_boundary(std::string_view path, size_t pos) {
+    return pos == path.size() || path[pos] == '/';
+}
+
+}
+
+RouteTrie::RouteTrie() : root_(std::make_unique<Node>()) {}
+
+const RouteTrie::Node* RouteTrie::find_child(const Node& node, char c) {
+    auto it = std::lower_bound(node.children.begin(), node.children.end(), c,
+        [](const std::unique_ptr<Node>& child, char key) { return child->label[0] < key; });
+    if (it == node.children.end() || (*it)->label[0] != c) {
+        return nullptr;
+    }
+    return it->get();
+}
+
+void RouteTrie::insert(std::string_view prefix, std::shared_ptr<RequestHandler> handler) {
+    while (!prefix.empty() && prefix.back() == '/') {
+        prefix.remove_suffix(1);
+    }
+
+    Node* node = root_.get();
+    while (!prefix.empty()) {
+        auto it = std::lower_bound(node->children.begin(), node->children.end(), prefix[0],
+            [](const std::unique_ptr<Node>& child, char key) { return child->label[0] < key; });
+
+        if (it == node->children.end() || (*it)->label[0] != prefix[0]) {
+            // No edge starts with this byte: the rest becomes a new leaf
+            auto leaf = std::make_unique<Node>();
+            leaf->label = std::string(prefix);
+            node = node->children.insert(it, std::move(leaf))->get();
+            break;
+        }
+
+        Node* child = it->get();
+        size_t common = 0;
+        while (common < child->label.size() && common < prefix.size() &&
+               child->label[common] == prefix[common]) {
+            ++common;
+        }
+
+        if (common < child->label.size()) {
+            // Split the edge; the existing child keeps the remaining suffix
+            auto split = std::make_unique<Node>();
+            split->label = child->label.substr(0, common);
+            child->label.erase(0, common);
+            split->children.push_back(std::move(*it));
+            *it = std::move(split);
+            child = it->get();
+        }
+
+        node = child;
+        prefix.remove_prefix(common);
+    }
+
+    if (!node->handler) {
+        ++size_;
+    }
+    node->handler = std::move(handler);
+}
+
+std::shared_ptr<RequestHandler> RouteTrie::match(std::string_view path) const {
+    size_t end = path.find_first_of("?#");
+    if (end != std::string_view::npos) {
+        path = path.substr(0, end);
+    }
+
+    const Node* node = root_.get();
+    const std::shared_ptr<RequestHandler>* best = nullptr;
+    if (node->handler && (path.empty() || path[0] == '/')) {
+        best = &node->handler;
+    }
+
+    size_t pos = 0;
+    while (pos < path.size()) {
+        node = find_child(*node, path[pos]);
+        if (!node || path.compare(pos, node->label.size(), node->label) != 0) {
+            break;
+        }
+        pos += node->label.size();
+        if (node->handler && is_boundary(path, pos)) {
+            best = &node->handler;
+        }
+    }
+    return best ? *best : nullptr;
+}
@@ -0,0 +1,43 @@
+#include "router_handle.h"
+
+namespace {
+
+std::atomic<uint64_t> next_handle_id{1};
+
+// Router last handed out on this thread
+struct CachedRouter {
+    uint64_t handle_id = 0;
+    uint64_t generation = 0;
+    std::shared_ptr<const PathRouter> router;
+};
+
+thread_local CachedRouter cached_router;
+
+}
+
+RouterHandle::RouterHandle(std::shared_ptr<const PathRouter> router)
+    : id_(next_handle_id.fetch_add(1, std::memory_order_relaxed)), router_(std::move(router)) {}
+
+std::shared_ptr<const PathRouter> RouterHandle::current() const {
+    uint64_t generation = generation_.load(std::memory_order_acquire);
+    if (cached_router.handle_id == id_ && cached_router.generation == generation) {
+        return cached_router.router;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    cached_router.handle_id = id_;
+    cached_router.generation = generation_.load(std::memory_order_relaxed);
+    cached_router.router = router_;
+    return cached_router.router;
+}
+
+void RouterHandle::publish(std::shared_ptr<const PathRouter> router) {
+    std::shared_ptr<const PathRouter> old;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        old = std::move(router_);
+        router_ = std::move(router);
+        generation_.fetch_add(1, std::memory_order_release);
+    }
+    // old is released here, outside the lock
+}
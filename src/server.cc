@@ -4,19 +4,41 @@
 
 using boost::asio::ip::tcp;
 
+typedef boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT> reuse_port_option;
+
 Server::Server(boost::asio::io_service& io_service, short port,
-               std::shared_ptr<PathRouter> router)
+               std::shared_ptr<RouterHandle> router,
+               std::shared_ptr<BufferPool> buffer_pool,
+               std::shared_ptr<BlockingExecutor> executor,
+               bool reuse_port,
+               const SessionOptions& options)
   : io_service_(io_service),
-    acceptor_(io_service, tcp::endpoint(tcp::v4(), port)),
-    router_(router)
+    acceptor_(io_service),
+    router_(router),
+    buffer_pool_(buffer_pool),
+    executor_(executor),
+    timer_wheel_(std::make_shared<TimerWheel>(io_service)),
+    options_(options)
 {
+  // Same steps as the endpoint constructor, plus SO_REUSEPORT before bind
+  tcp::endpoint endpoint(tcp::v4(), port);
+  acceptor_.open(endpoint.protocol());
+  acceptor_.set_option(tcp::acceptor::reuse_address(true));
+  if (reuse_port) {
+    acceptor_.set_option(reuse_port_option(true));
+  }
+  acceptor_.bind(endpoint);
+  acceptor_.listen();
+
+  timer_wheel_->start();
   start_accept();
 }
 
 void Server::start_accept()
 {
   std::shared_ptr<Session> new_session = 
-      std::make_shared<Session>(io_service_, router_);
+      std::make_shared<Session>(io_service_, router_, buffer_pool_, executor_,
+                                timer_wheel_, options_);
   
   acceptor_.async_accept(new_session->socket(),
       boost::bind(&Server::handle_accept, this, new_session,
@@ -1,6 +1,7 @@
 // server_config.cc
 #include "server_config.h"
 #include <iostream>
+#include <stdexcept>
 
 // Disclaimer: This functionality is written by our group, and wrapped in the server config object with the help with Claude Sonnet 4.5. (Tony)
 bool ServerConfig::load_from_nginx_config(const NginxConfig& config) {
@@ -22,6 +23,82 @@ bool ServerConfig::load_from_nginx_config(const NginxConfig& config) {
                     }
                 }
                 
+                // Parse threading model: "thread_mode shared;" or "thread_mode per_core;"
+                if (server_statement->tokens_[0] == "thread_mode" && server_statement->tokens_.size() >= 2) {
+                    const std::string& mode = server_statement->tokens_[1];
+                    if (mode == "shared") {
+                        thread_mode_ = ThreadMode::Shared;
+                    } else if (mode == "per_core") {
+                        thread_mode_ = ThreadMode::PerCore;
+                    } else {
+                        std::cerr << "Invalid thread_mode: " << mode << "\n";
+                        return false;
+                    }
+                }
+                
+                // Parse how file bodies are read: "file_io sendfile;" or "file_io async;"
+                if (server_statement->tokens_[0] == "file_io" && server_statement->tokens_.size() >= 2) {
+                    const std::string& mode = server_statement->tokens_[1];
+                    if (mode == "sendfile") {
+                        file_io_ = FileIo::Sendfile;
+                    } else if (mode == "async") {
+                        file_io_ = FileIo::Async;
+                    } else {
+                        std::cerr << "Invalid file_io: " << mode << "\n";
+                        return false;
+                    }
+                }
+                
+                // Parse size of the worker pool that runs blocking handlers
+                if (server_statement->tokens_[0] == "blocking_threads" && server_statement->tokens_.size() >= 2) {
+                    try {
+                        blocking_threads_ = std::stoi(server_statement->tokens_[1]);
+                    } catch (...) {
+                        blocking_threads_ = 0;
+                    }
+                    if (blocking_threads_ <= 0) {
+                        std::cerr << "Invalid blocking_threads\n";
+                        return false;
+                    }
+                }
+                
+                // Parse connection timeouts, in seconds
+                if ((server_statement->tokens_[0] == "idle_timeout" ||
+                     server_statement->tokens_[0] == "header_timeout" ||
+                     server_statement->tokens_[0] == "body_timeout") &&
+                    server_statement->tokens_.size() >= 2) {
+                    int seconds = -1;
+                    try {
+                        seconds = std::stoi(server_statement->tokens_[1]);
+                    } catch (...) {
+                    }
+                    if (seconds < 0) {
+                        std::cerr << "Invalid " << server_statement->tokens_[0] << "\n";
+                        return false;
+                    }
+                    if (server_statement->tokens_[0] == "idle_timeout") {
+                        idle_timeout_ = seconds;
+                    } else if (server_statement->tokens_[0] == "header_timeout") {
+                        header_timeout_ = seconds;
+                    } else {
+                        body_timeout_ = seconds;
+                    }
+                }
+                
+                // Parse body size limit, in bytes
+                if (server_statement->tokens_[0] == "max_body_size" && server_statement->tokens_.size() >= 2) {
+                    try {
+                        size_t parsed = 0;
+                        max_body_size_ = std::stoull(server_statement->tokens_[1], &parsed);
+                        if (parsed != server_statement->tokens_[1].size()) {
+                            throw std::invalid_argument("trailing characters");
+                        }
+                    } catch (...) {
+                        std::cerr << "Invalid max_body_size\n";
+                        return false;
+                    }
+                }
+                
                 // Parse location blocks
                 if (server_statement->tokens_[0] == "location" && server_statement->tokens_.size() >= 2) {
                     std::string path = server_statement->tokens_[1];
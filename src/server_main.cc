@@ -10,12 +10,117 @@
 #include "server.h"
 #include "server_config.h"
 #include "path_router.h"
+#include "router_handle.h"
+#include <boost/asio/signal_set.hpp>
 #include <cstdlib>
 #include <iostream>
 #include <thread>
 #include <vector>
-#include "server.h"
 #include "logger.h"
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+static SessionOptions session_options(const ServerConfig& server_config,
+                                      std::shared_ptr<FileReader> file_reader)
+{
+  SessionOptions options;
+  options.file_reader = std::move(file_reader);
+  options.idle_timeout = std::chrono::seconds(server_config.get_idle_timeout());
+  options.header_timeout = std::chrono::seconds(server_config.get_header_timeout());
+  options.body_timeout = std::chrono::seconds(server_config.get_body_timeout());
+  options.max_body_bytes = server_config.get_max_body_size();
+  return options;
+}
+
+// Re-reads the config and publishes a router built from its locations.
+// Sessions pick it up with their next request; requests already running
+// finish with the handlers they started with. Listener, thread and timeout
+// settings only change on restart.
+static void reload_router(const std::string& config_path, RouterHandle& routers)
+{
+  Logger *logger = Logger::getLogger();
+
+  NginxConfigParser parser;
+  NginxConfig config;
+  ServerConfig server_config;
+  if (!parser.Parse(config_path.c_str(), &config) ||
+      !server_config.load_from_nginx_config(config)) {
+    logger->logErrorFile("Reload failed, keeping the current configuration");
+    return;
+  }
+
+  routers.publish(std::make_shared<PathRouter>(server_config));
+  logger->logTraceFile("Reloaded configuration (generation " +
+                       std::to_string(routers.generation()) + ")");
+}
+
+// SIGHUP triggers a reload; re-armed after each one
+static void watch_for_reload(boost::asio::signal_set& signals, const std::string& config_path,
+                             std::shared_ptr<RouterHandle> routers)
+{
+  signals.async_wait([&signals, config_path, routers](const boost::system::error_code& error, int) {
+    if (error) {
+      return;
+    }
+    reload_router(config_path, *routers);
+    watch_for_reload(signals, config_path, routers);
+  });
+}
+
+// Best effort: keep a per-core worker on its own CPU
+static void pin_to_cpu(std::thread& thread, size_t cpu)
+{
+#ifdef __linux__
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(cpu, &cpus);
+  pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus);
+#endif
+}
+
+// Thread-per-core mode: every core gets its own io_service, acceptor and
+// buffer pool. The acceptors share the port through SO_REUSEPORT, so the
+// kernel picks the core for each new connection and a session then stays on
+// that thread for its whole lifetime. Blocking handlers still go to the
+// shared executor, so they do not stall the other connections on a core.
+static void run_per_core(const ServerConfig& server_config, const std::string& config_path,
+                         std::shared_ptr<RouterHandle> router,
+                         std::shared_ptr<BlockingExecutor> executor,
+                         std::shared_ptr<FileReader> file_reader, size_t num_cores)
+{
+  Logger *logger = Logger::getLogger();
+
+  std::vector<std::unique_ptr<boost::asio::io_service>> io_services;
+  std::vector<std::unique_ptr<Server>> servers;
+  for (size_t i = 0; i < num_cores; ++i) {
+    // A concurrency hint of 1 lets asio skip locking meant for shared reactors
+    io_services.push_back(std::make_unique<boost::asio::io_service>(1));
+    servers.push_back(std::make_unique<Server>(*io_services.back(),
+        server_config.get_port(), router, std::make_shared<BufferPool>(), executor, true,
+        session_options(server_config, file_reader)));
+  }
+
+  boost::asio::signal_set signals(*io_services.front(), SIGHUP);
+  watch_for_reload(signals, config_path, router);
+
+  logger->logServerInitialization();
+  logger->logTraceFile("Starting server on port: " + std::to_string(server_config.get_port()));
+  logger->logTraceFile("Starting " + std::to_string(num_cores) + " per-core workers");
+
+  std::vector<std::thread> thread_pool;
+  for (size_t i = 0; i < num_cores; ++i) {
+    boost::asio::io_service& io_service = *io_services[i];
+    thread_pool.emplace_back([&io_service]() {
+      io_service.run();
+    });
+    pin_to_cpu(thread_pool.back(), i);
+  }
+
+  for (auto& thread : thread_pool) {
+    thread.join();
+  }
+}
 
 int main(int argc, char* argv[])
 {
@@ -45,21 +150,42 @@ int main(int argc, char* argv[])
       return -1;
     }
 
-    // Initialize router with config
-    auto router = std::make_shared<PathRouter>(server_config);
+    // Initialize router with config; SIGHUP swaps in a new one
+    auto router = std::make_shared<RouterHandle>(std::make_shared<PathRouter>(server_config));
+
+    size_t detected = std::thread::hardware_concurrency();
+    if (detected == 0) detected = 1;
+
+    // Worker threads for handlers that block, shared by every io_service
+    auto executor = std::make_shared<BlockingExecutor>(server_config.get_blocking_threads());
+
+    // One ring (or the executor) serves the file reads of every io_service
+    std::shared_ptr<FileReader> file_reader;
+    if (server_config.get_file_io() == FileIo::Async) {
+      file_reader = FileReader::create(executor);
+      logger->logTraceFile(std::string("Reading files with ") + file_reader->backend());
+    }
+
+    if (server_config.get_thread_mode() == ThreadMode::PerCore) {
+      run_per_core(server_config, argv[1], router, executor, file_reader, detected);
+      return 0;
+    }
+
+    // Read buffers shared by every connection
+    auto buffer_pool = std::make_shared<BufferPool>();
 
     // Start server
     boost::asio::io_service io_service;
 
     using namespace std; // For atoi.
 
-    Server s(io_service, server_config.get_port(), router);
+    Server s(io_service, server_config.get_port(), router, buffer_pool, executor, false,
+             session_options(server_config, file_reader));
+    boost::asio::signal_set signals(io_service, SIGHUP);
+    watch_for_reload(signals, argv[1], router);
     logger->logServerInitialization();
     logger->logTraceFile("Starting server on port: " + std::to_string(server_config.get_port()));
 
-    size_t detected = std::thread::hardware_concurrency();
-    if (detected == 0) detected = 1;
-
     const size_t num_threads = std::max<size_t>(4, detected);
 
     logger->logTraceFile("Starting " + std::to_string(num_threads) + " worker threads");
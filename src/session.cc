@@ -1,16 +1,27 @@
 #include "session.h"
 #include "http_request.h"
-#include "http_helper.h"
-#include "path_router.h"
+#include "http_request_parser.h"
+#include "router_handle.h"
 #include "echo_handler.h"
 #include "file_handler.h"
+#include "http_helper.h"
 #include "logger.h"
 #include <boost/bind.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 
 Session::Session(boost::asio::io_service& io_service,
-                 std::shared_ptr<PathRouter> router)
-  : socket_(io_service), router_(router)
+                 std::shared_ptr<RouterHandle> router,
+                 std::shared_ptr<BufferPool> buffer_pool,
+                 std::shared_ptr<BlockingExecutor> executor,
+                 std::shared_ptr<TimerWheel> timer_wheel,
+                 const SessionOptions& options)
+  : socket_(io_service), buffer_pool_(buffer_pool), router_(router),
+    executor_(executor), strand_(boost::asio::make_strand(io_service)),
+    timer_wheel_(timer_wheel), options_(options)
 {
+  parser_.set_max_body_bytes(options_.max_body_bytes);
 }
 
 tcp::socket& Session::socket()
@@ -19,203 +30,685 @@ tcp::socket& Session::socket()
 }
 
 void Session::start()
+{
+  // Lets handle_readable() read without blocking if the wakeup was spurious
+  boost::system::error_code ec;
+  socket_.non_blocking(true, ec);
+
+  // From here on everything runs on the strand, including the first read
+  auto self = shared_from_this();
+  boost::asio::dispatch(strand_, [self]() {
+    self->do_read();
+  });
+}
+
+void Session::do_read()
 {
   auto self = shared_from_this();
-  socket_.async_read_some(boost::asio::buffer(data_, max_length),
-      boost::bind(&Session::handle_read, self,
-        boost::asio::placeholders::error,
-        boost::asio::placeholders::bytes_transferred));
+  update_read_deadline();
+
+  if (parser_.buffered_bytes() == 0) {
+    // Between requests: return the buffer to the pool and only take one
+    // back once the socket has data, so idle connections hold no buffer.
+    read_buffer_ = BufferPool::Buffer();
+    socket_.async_wait(tcp::socket::wait_read,
+        boost::asio::bind_executor(strand_,
+          boost::bind(&Session::handle_readable, self,
+            boost::asio::placeholders::error)));
+    return;
+  }
+
+  size_t wanted = BufferPool::size_class(next_read_size());
+  if (read_buffer_.size() != wanted) {
+    read_buffer_ = buffer_pool_->acquire(wanted);
+  }
+  socket_.async_read_some(boost::asio::buffer(read_buffer_.data(), read_buffer_.size()),
+      boost::asio::bind_executor(strand_,
+        boost::bind(&Session::handle_read, self,
+          boost::asio::placeholders::error,
+          boost::asio::placeholders::bytes_transferred)));
+}
+
+void Session::handle_readable(const boost::system::error_code& error)
+{
+  // A read that completed just before a timeout cancelled it is dropped
+  if (error || closing_)
+  {
+    return;
+  }
+
+  read_buffer_ = buffer_pool_->acquire(next_read_size());
+
+  boost::system::error_code ec;
+  size_t bytes_transferred = socket_.read_some(
+      boost::asio::buffer(read_buffer_.data(), read_buffer_.size()), ec);
+  if (ec == boost::asio::error::would_block || ec == boost::asio::error::try_again) {
+    do_read();
+    return;
+  }
+  handle_read(ec, bytes_transferred);
+}
+
+// Size the next read from what we know about the request in progress: the
+// rest of a Content-Length body if we are in one, otherwise the adaptive hint.
+size_t Session::next_read_size() const
+{
+  size_t wanted = read_hint_;
+  if (parser_.state() == HttpRequestParser::State::Body && !parser_.is_chunked()) {
+    size_t remaining = parser_.content_length() - parser_.body_received();
+    wanted = std::max(wanted, remaining);
+  }
+  return std::min<size_t>(wanted, BufferPool::kMaxBufferSize);
 }
 
 void Session::handle_read(const boost::system::error_code& error,
     size_t bytes_transferred)
 {
-  if (!error)
+  if (error || closing_)
   {
-    // Accumulate bytes into buffer
-    buffer_.append(data_, bytes_transferred);
-
-
-    MalformedType malformed = check_malformed_request(buffer_);
-    if (malformed != MalformedType::None) {
-         HttpResponse response("HTTP/1.1", 400, "Bad Request",
-             {{"Content-Type", "text/plain"}}, "Malformed HTTP request");
-
-         HttpRequest request = HttpRequest::parse(buffer_);
-         Logger * logger = Logger::getLogger();
-    
-         std::string response_str = response.convert_to_string();
-    
-         auto self = shared_from_this();
-         boost::asio::async_write(socket_,
-             boost::asio::buffer(response_str),
-             boost::bind(&Session::handle_write, self,
-                 boost::asio::placeholders::error));
-
-         std::string client_ip = "unknown";
-         try {
-             client_ip = socket_.remote_endpoint().address().to_string();
-         } catch (...) {
-             // Socket might be closed, use "unknown"
-         }
-         logger->logMachineParsable("[ResponseMetrics] response_code:400 path:" + request.path() + 
-                   " handler:MalformedRequest ip:" + client_ip);
-    
-         buffer_.clear();
-         return;
+    return;
+  }
+
+  // Grow the read size while reads keep filling the buffer, and shrink it
+  // again when they come back mostly empty.
+  if (bytes_transferred == read_buffer_.size()) {
+    read_hint_ = std::min<size_t>(read_hint_ * 2, BufferPool::kMaxBufferSize);
+  } else if (bytes_transferred < read_buffer_.size() / 4) {
+    read_hint_ = std::max<size_t>(read_hint_ / 2, BufferPool::kMinBufferSize);
+  }
+
+  // The parser resumes where the previous chunk left off
+  parser_.feed(read_buffer_.data(), bytes_transferred);
+  process_buffered_requests();
+}
+
+// Handle every complete request already in the parser's buffer, in order.
+// Pipelined requests are answered in the order they arrived, and all of
+// their responses go out in a single write.
+void Session::process_buffered_requests()
+{
+  Logger * logger = Logger::getLogger();
+
+  while (true) {
+    stream_body_data();
+    if (parser_.state() != HttpRequestParser::State::Complete) {
+      break;
     }
 
-    // \n\n for macOS
-    if (detect_http_request(buffer_)) {
-      
-      HttpRequest request = HttpRequest::parse(buffer_);
-
-      // Large inputs converted to chunks, aggregate chunks into single request
-      // Note: following code until (~129) written with assistance from Claude AI
-      auto content_length_opt = request.get_header("Content-Length");
-      if (content_length_opt.has_value()) {
-        size_t content_length = 0;
-        try {
-          content_length = std::stoull(content_length_opt.value());
-        } catch (const std::exception& e) {
-          // Invalid Content-Length header
-          Logger * logger = Logger::getLogger();
-          logger->logDebugFile("Invalid Content-Length header");
-          
-          HttpResponse response = HttpResponse("HTTP/1.1", 400, "Bad Request",
-              {{"Content-Type", "text/plain"}}, "Invalid Content-Length header");
-          
-          std::string response_str = response.convert_to_string();
-          
-          auto self = shared_from_this();
-          boost::asio::async_write(socket_,
-            boost::asio::buffer(response_str),
-            boost::bind(&Session::handle_write, self,
-              boost::asio::placeholders::error));
-
-          std::string client_ip = "unknown";
-          try {
-              client_ip = socket_.remote_endpoint().address().to_string();
-          } catch (...) {}
-          logger->logMachineParsable("[ResponseMetrics] response_code:400 path:" + request.path() + 
-                        " handler:MalformedRequest ip:" + client_ip);
-          
-          buffer_.clear();
-          return;
-        }
-        
-        size_t header_end = buffer_.find("\r\n\r\n");
-        if (header_end == std::string::npos) {
-          header_end = buffer_.find("\n\n");
-        }
-        
-        size_t body_start = (buffer_.find("\r\n\r\n") != std::string::npos) 
-                            ? header_end + 4 
-                            : header_end + 2;
-        size_t body_received = buffer_.size() - body_start;
-        
-        if (body_received < content_length) {
-          auto self = shared_from_this();
-          socket_.async_read_some(boost::asio::buffer(data_, max_length),
-              boost::bind(&Session::handle_read, self,
-                boost::asio::placeholders::error,
-                boost::asio::placeholders::bytes_transferred));
-          Logger * logger = Logger::getLogger();
-          logger->logDebugFile("Waiting for complete body: " + 
-                              std::to_string(body_received) + "/" + 
-                              std::to_string(content_length) + " bytes");
-          return;
-        }
-      }
+    // Bytes of the next pipelined request stay in the parser
+    HttpRequest request = parser_.take_request();
+    body_handler_checked_ = false;
+    if (!handle_request(std::move(request), std::move(body_handler_), std::move(body_sink_))) {
+      // A blocking handler has it; finish_blocking_request() picks up the
+      // remaining requests once its response is queued, keeping them in order
+      return;
+    }
+  }
 
-      if(!request.is_valid()){
-          Logger * logger = Logger::getLogger();
-          logger->logDebugFile("Received malformed HTTP request");
-          
-          HttpResponse response = HttpResponse("HTTP/1.1", 400, "Bad Request",
-              {{"Content-Type", "text/plain"}}, "Malformed HTTP request");
-          
-          std::string response_str = response.convert_to_string();
-          
-          auto self = shared_from_this();
-          boost::asio::async_write(socket_,
-            boost::asio::buffer(response_str),
-            boost::bind(&Session::handle_write, self,
-              boost::asio::placeholders::error));
-
-          std::string client_ip = "unknown";
-          try {
-              client_ip = socket_.remote_endpoint().address().to_string();
-          } catch (...) {
-              // Socket might be closed, use "unknown"
-          }
-          logger->logMachineParsable("[ResponseMetrics] response_code:400 path:" + request.path() + 
-                         " handler:MalformedRequest ip:" + client_ip);
-          
-          buffer_.clear();
-          return;
-      }
+  if (parser_.state() == HttpRequestParser::State::Error) {
+    logger->logDebugFile("Received malformed HTTP request: " + parser_.error_message());
 
-      Logger * logger = Logger::getLogger();
+    int status_code = parser_.error_status_code();
+    HttpResponse response("HTTP/1.1", status_code, reason_phrase(status_code),
+        {{"Content-Type", "text/plain"}, {"Connection", "close"}}, parser_.error_message());
+    std::string path(parser_.target());
 
-      std::unique_ptr<RequestHandler> handler = router_->match_handler(request.path());
+    // The stream cannot be resynchronized. Whatever follows, buffered or
+    // still on the wire, may be a body the client filled with requests of
+    // its own, so none of it is parsed and the connection ends once the
+    // response is out.
+    parser_.reset();
+    body_handler_.reset();
+    body_sink_.reset();
+    body_handler_checked_ = false;
+    closing_ = true;
+    queue_response(std::move(response), path, "MalformedRequest");
+  }
 
-      HttpResponse response;
-      std::string handler_name = "NotFoundHandler";
+  if (!write_queue_.empty()) {
+    start_write();
+    return;
+  }
 
-      if (handler) {  
-        handler_name = handler->get_handler_name();
-        logger->logDebugFile("Request for path '" + request.path() + "' is being handled by " + handler->get_handler_name());
-        response = handler->handle_request(request);
-      } else {
-        // Fallback for unknown paths
-        logger->logDebugFile("No handler found for path: " + request.path());
-        response = HttpResponse("HTTP/1.1", 404, "Not Found", 
-          {{"Content-Type", "text/html"}}, "<h1>404 Not Found</h1>");
-      }
+  if (parser_.state() == HttpRequestParser::State::Body && parser_.is_chunked()) {
+    logger->logDebugFile("Waiting for more chunked body: " +
+                        std::to_string(parser_.body_received()) + " bytes so far");
+  } else if (parser_.state() == HttpRequestParser::State::Body) {
+    logger->logDebugFile("Waiting for complete body: " +
+                        std::to_string(parser_.body_received()) + "/" +
+                        std::to_string(parser_.content_length()) + " bytes");
+  } else {
+    logger->logDebugFile("Read handler ");
+  }
+  do_read();
+}
 
-      std::string response_str = response.convert_to_string();
+// Once the headers of a chunked request are in, ask its handler for a sink
+// to take the body as it arrives; if it gave one, hand over what has been
+// decoded.
+void Session::stream_body_data()
+{
+  HttpRequestParser::State state = parser_.state();
+  if (!parser_.is_chunked() ||
+      (state != HttpRequestParser::State::Body && state != HttpRequestParser::State::Complete)) {
+    return;
+  }
 
-      auto self = shared_from_this();
-      boost::asio::async_write(socket_,
-        boost::asio::buffer(response_str),
-        boost::bind(&Session::handle_write, self,
-          boost::asio::placeholders::error));
+  if (!body_handler_checked_) {
+    body_handler_checked_ = true;
+    HttpRequest head;
+    head.set_method(std::string(parser_.method()));
+    head.set_path(std::string(parser_.target()));
+    head.set_version(std::string(parser_.version()));
+    for (const auto& [name, value] : parser_.headers()) {
+      head.add_header(std::string(name), std::string(value));
+    }
+    std::shared_ptr<RequestHandler> handler = router_->current()->match_handler(head.path());
+    if (handler) {
+      body_sink_ = handler->begin_body(head);
+    }
+    if (body_sink_) {
+      body_handler_ = std::move(handler);
+    }
+  }
+
+  if (body_sink_) {
+    std::string data = parser_.take_body_data();
+    if (!data.empty()) {
+      body_sink_->write(data);
+    }
+  }
+}
+
+// Returns false if the request was handed to the blocking executor, in which
+// case its response is queued later by finish_blocking_request().
+bool Session::handle_request(HttpRequest request,
+    std::shared_ptr<RequestHandler> handler, std::unique_ptr<BodySink> body)
+{
+  Logger * logger = Logger::getLogger();
+
+  if (!request.is_valid()) {
+    logger->logDebugFile("Received malformed HTTP request");
+
+    HttpResponse response("HTTP/1.1", 400, "Bad Request",
+        {{"Content-Type", "text/plain"}}, "Malformed HTTP request");
+    queue_response(std::move(response), request.path(), "MalformedRequest");
+    return true;
+  }
 
-      std::string client_ip = "unknown";
-      try {
-          client_ip = socket_.remote_endpoint().address().to_string();
-      } catch (...) {
-          // Socket might be closed, use "unknown"
+  // A handler that streamed the body was already picked when its headers arrived
+  if (!handler) {
+    handler = router_->current()->match_handler(request.path());
+  }
+
+  HttpResponse response;
+  std::string handler_name = "NotFoundHandler";
+
+  if (handler && handler->is_blocking() && executor_) {
+    handler_name = handler->get_handler_name();
+    logger->logDebugFile("Request for path '" + request.path() + "' is being handled by " + handler_name + " on the blocking executor");
+    if (dispatch_blocking(std::move(handler), std::make_shared<HttpRequest>(std::move(request)),
+        std::move(body))) {
+      // The handler's run time is not the client's fault
+      if (timer_wheel_) {
+        timer_wheel_->clear_deadline(*this);
       }
-      logger->logMachineParsable("[ResponseMetrics] response_code:" + std::to_string(response.get_status_code()) + 
-                     " path:" + request.path() + " handler:" + handler_name + " ip:" + client_ip);
+      return false;
+    }
+
+    // Executor is saturated; shed the request rather than block this thread
+    logger->logDebugFile("Blocking executor is full, rejecting request");
+    response = HttpResponse("HTTP/1.1", 503, reason_phrase(503),
+      {{"Content-Type", "text/plain"}}, "Server busy");
+  } else if (handler) {
+    handler_name = handler->get_handler_name();
+    logger->logDebugFile("Request for path '" + request.path() + "' is being handled by " + handler->get_handler_name());
+    response = body ? handler->handle_streamed_request(request, *body)
+                    : handler->handle_request(request);
+  } else {
+    // Fallback for unknown paths
+    logger->logDebugFile("No handler found for path: " + request.path());
+    response = HttpResponse("HTTP/1.1", 404, "Not Found",
+      {{"Content-Type", "text/html"}}, "<h1>404 Not Found</h1>");
+  }
+
+  queue_response(std::move(response), request.path(), handler_name);
+  return true;
+}
+
+// Runs the handler on an executor thread and posts the response back to the
+// session's strand. Returns false if the executor refused the work.
+bool Session::dispatch_blocking(std::shared_ptr<RequestHandler> handler,
+    std::shared_ptr<HttpRequest> request, std::shared_ptr<BodySink> body)
+{
+  auto self = shared_from_this();
+  return executor_->submit([self, handler, request, body]() {
+    HttpResponse response;
+    try {
+      response = body ? handler->handle_streamed_request(*request, *body)
+                      : handler->handle_request(*request);
+    } catch (const std::exception& e) {
+      Logger::getLogger()->logErrorFile("Blocking handler failed: " + std::string(e.what()));
+      response = HttpResponse("HTTP/1.1", 500, "Internal Server Error",
+        {{"Content-Type", "text/plain"}}, "Internal Server Error");
+    } catch (...) {
+      // Nothing may escape into the pool thread, or the client never hears back
+      Logger::getLogger()->logErrorFile("Blocking handler failed with a non-standard exception");
+      response = HttpResponse("HTTP/1.1", 500, "Internal Server Error",
+        {{"Content-Type", "text/plain"}}, "Internal Server Error");
+    }
+
+    boost::asio::post(self->strand_,
+      [self, request, handler, response = std::move(response)]() mutable {
+        self->finish_blocking_request(std::move(response), request->path(),
+            handler->get_handler_name());
+      });
+  });
+}
+
+void Session::finish_blocking_request(HttpResponse response, const std::string& path,
+    const std::string& handler_name)
+{
+  queue_response(std::move(response), path, handler_name);
+  process_buffered_requests();
+}
+
+void Session::queue_response(HttpResponse response, const std::string& path,
+    const std::string& handler_name)
+{
+  int status_code = response.get_status_code();
+
+  // Must outlive the async_write, so it lives in the session. The body is
+  // moved in and written from where it is, only the head is serialized,
+  // and a prepared response brings its head along.
+  OutgoingResponse outgoing;
+  if (!response.is_prepared()) {
+    outgoing.head = response.serialize_head();
+  }
+  outgoing.response = std::move(response);
+  write_queue_.push_back(std::move(outgoing));
+
+  std::string client_ip = "unknown";
+  try {
+      client_ip = socket_.remote_endpoint().address().to_string();
+  } catch (...) {
+      // Socket might be closed, use "unknown"
+  }
+  Logger * logger = Logger::getLogger();
+  logger->logMachineParsable("[ResponseMetrics] response_code:" + std::to_string(status_code) +
+                 " path:" + path + " handler:" + handler_name + " ip:" + client_ip);
+}
+
+// Gather queued heads and bodies into one write instead of copying them into
+// a single string first. A streamed body ends the batch after its head; the
+// responses queued behind it wait until the stream is done.
+void Session::start_write()
+{
+  std::vector<boost::asio::const_buffer> buffers;
+  size_t count = 0;
+  for (const OutgoingResponse& outgoing : write_queue_) {
+    std::vector<boost::asio::const_buffer> parts = outgoing.response.to_buffers(outgoing.head);
+    buffers.insert(buffers.end(), parts.begin(), parts.end());
+    ++count;
+    if (outgoing.response.get_body_stream()) {
+      break;
+    }
+  }
+
+  // A client that stops draining its responses counts as idle
+  set_timeout(TimeoutPhase::Idle, options_.idle_timeout);
+
+  auto self = shared_from_this();
+  boost::asio::async_write(socket_, buffers,
+    boost::asio::bind_executor(strand_,
+      boost::bind(&Session::handle_write, self,
+        boost::asio::placeholders::error, count)));
+}
+
+void Session::handle_write(const boost::system::error_code& error, size_t count)
+{
+  if (error)
+  {
+    return;
+  }
 
-      buffer_.clear();
+  Logger * logger = Logger::getLogger();
+  logger->logDebugFile("write handler");
 
+  body_stream_ = write_queue_[count - 1].response.get_body_stream();
+  write_queue_.erase(write_queue_.begin(), write_queue_.begin() + count);
+
+  if (body_stream_) {
+    body_chunked_ = !body_stream_->size();
+    write_body_piece();
+    return;
+  }
+  continue_writing();
+}
+
+// Pull the next piece of a streamed body. Only one piece is in flight at a
+// time, so the producer runs no faster than the client reads.
+void Session::write_body_piece()
+{
+  // Files skip the user-space buffer entirely, unless they are to be read
+  // without blocking this thread
+  if (auto* file = dynamic_cast<FileBody*>(body_stream_.get())) {
+    if (options_.file_reader) {
+      read_file_piece(*file);
     } else {
-      // keep reading if empty line not found
-      auto self = shared_from_this();
-      socket_.async_read_some(boost::asio::buffer(data_, max_length),
-          boost::bind(&Session::handle_read, self,
-            boost::asio::placeholders::error,
-            boost::asio::placeholders::bytes_transferred));
-      Logger * logger = Logger::getLogger();
-      logger->logDebugFile("Read handler ");
+      send_file_piece(*file);
     }
+    return;
+  }
+  // Mapped files are written from the page cache without a copy
+  if (auto* mapped = dynamic_cast<MappedBody*>(body_stream_.get())) {
+    send_mapped_piece(*mapped);
+    return;
+  }
+
+  if (!body_buffer_) {
+    body_buffer_ = buffer_pool_->acquire(BufferPool::kMaxBufferSize);
+  }
+
+  // Chunked encoding needs room for "<hex size>\r\n" before the data and
+  // "\r\n" after it
+  const size_t prefix = body_chunked_ ? 18 : 0;
+  const size_t suffix = body_chunked_ ? 2 : 0;
+  char* data = body_buffer_.data() + prefix;
+
+  size_t n = 0;
+  try {
+    n = body_stream_->read(data, body_buffer_.size() - prefix - suffix);
+  } catch (const std::exception& e) {
+    // Part of the response may be out already; the only honest option left
+    // is to drop the connection
+    Logger::getLogger()->logErrorFile("Response body failed: " + std::string(e.what()));
+    boost::system::error_code ec;
+    socket_.close(ec);
+    return;
+  }
+
+  if (n == 0 && !body_chunked_) {
+    finish_body();
+    return;
+  }
+
+  char* start = data;
+  size_t length = n;
+  if (body_chunked_ && n == 0) {
+    static const char kLastChunk[] = "0\r\n\r\n";
+    start = body_buffer_.data();
+    length = sizeof(kLastChunk) - 1;
+    std::memcpy(start, kLastChunk, length);
+  } else if (body_chunked_) {
+    char size_line[24];
+    int size_length = std::snprintf(size_line, sizeof(size_line), "%zx\r\n", n);
+    start -= size_length;
+    std::memcpy(start, size_line, size_length);
+    std::memcpy(data + n, "\r\n", 2);
+    length = size_length + n + 2;
+  }
+
+  set_timeout(TimeoutPhase::Idle, options_.idle_timeout);
+
+  auto self = shared_from_this();
+  boost::asio::async_write(socket_, boost::asio::buffer(start, length),
+    boost::asio::bind_executor(strand_,
+      boost::bind(&Session::handle_body_write, self,
+        boost::asio::placeholders::error, n == 0)));
+}
+
+// Send one slice of a file with sendfile(2). The socket is non-blocking, so
+// when it is full we wait for it to become writable instead of blocking.
+// Between slices the strand is given up so other sessions get a turn.
+void Session::send_file_piece(FileBody& file)
+{
+  static const size_t kMaxSlice = 1024 * 1024;
+
+  bool would_block = false;
+  size_t sent = 0;
+  try {
+    sent = file.send_to(socket_.native_handle(), kMaxSlice, would_block);
+  } catch (const std::exception& e) {
+    Logger::getLogger()->logErrorFile("Response body failed: " + std::string(e.what()));
+    boost::system::error_code ec;
+    socket_.close(ec);
+    return;
+  }
+
+  auto self = shared_from_this();
+  if (would_block) {
+    set_timeout(TimeoutPhase::Idle, options_.idle_timeout);
+    socket_.async_wait(tcp::socket::wait_write,
+      boost::asio::bind_executor(strand_,
+        boost::bind(&Session::handle_body_write, self,
+          boost::asio::placeholders::error, false)));
+    return;
+  }
+
+  if (sent == 0) {
+    finish_body();
+    return;
+  }
+  boost::asio::post(strand_, [self]() {
+    self->write_body_piece();
+  });
+}
+
+// Write the next slice of a mapped file directly from its pages. The body
+// holds the mapping until finish_body(), so the buffer outlives the write.
+void Session::send_mapped_piece(MappedBody& mapped)
+{
+  static const size_t kMaxSlice = 1024 * 1024;
+
+  std::string_view span = mapped.next_span(kMaxSlice);
+  if (span.empty()) {
+    finish_body();
+    return;
+  }
+
+  set_timeout(TimeoutPhase::Idle, options_.idle_timeout);
+
+  auto self = shared_from_this();
+  boost::asio::async_write(socket_, boost::asio::buffer(span.data(), span.size()),
+    boost::asio::bind_executor(strand_,
+      boost::bind(&Session::handle_body_write, self,
+        boost::asio::placeholders::error, false)));
+}
+
+// Have the FileReader fill the body buffer with the next piece of the file.
+// The I/O thread moves on to other sessions until the read completes. If
+// the reader cannot take the read, the piece goes out with sendfile(2).
+void Session::read_file_piece(FileBody& file)
+{
+  if (file.remaining() == 0) {
+    finish_body();
+    return;
+  }
+  if (!body_buffer_) {
+    body_buffer_ = buffer_pool_->acquire(BufferPool::kMaxBufferSize);
+  }
+
+  set_timeout(TimeoutPhase::Idle, options_.idle_timeout);
+
+  // The session, and with it the buffer and the file, stay alive until the
+  // completion has run on the strand
+  auto self = shared_from_this();
+  bool queued = options_.file_reader->read(file.fd(), file.next_offset(), body_buffer_.data(),
+      std::min(body_buffer_.size(), file.remaining()),
+      [self](ssize_t result) {
+        boost::asio::post(self->strand_, [self, result]() {
+          self->handle_file_read(result);
+        });
+      });
+  if (!queued) {
+    send_file_piece(file);
+  }
+}
+
+void Session::handle_file_read(ssize_t result)
+{
+  auto* file = dynamic_cast<FileBody*>(body_stream_.get());
+  if (!file || result <= 0) {
+    // The Content-Length is already on the wire, so a short file is an error
+    Logger::getLogger()->logErrorFile("Response body failed: " +
+        std::string(result == 0 ? "File shrank while being sent" : std::strerror(static_cast<int>(-result))));
+    boost::system::error_code ec;
+    socket_.close(ec);
+    return;
   }
+  file->consume(static_cast<size_t>(result));
+
+  auto self = shared_from_this();
+  boost::asio::async_write(socket_, boost::asio::buffer(body_buffer_.data(), static_cast<size_t>(result)),
+    boost::asio::bind_executor(strand_,
+      boost::bind(&Session::handle_body_write, self,
+        boost::asio::placeholders::error, false)));
 }
 
-void Session::handle_write(const boost::system::error_code& error)
+void Session::handle_body_write(const boost::system::error_code& error, bool last)
 {
-  if (!error)
+  if (error)
   {
-    auto self = shared_from_this();
-    socket_.async_read_some(boost::asio::buffer(data_, max_length),
-        boost::bind(&Session::handle_read, self,
-          boost::asio::placeholders::error,
-          boost::asio::placeholders::bytes_transferred));
-        Logger * logger = Logger::getLogger();
-        logger->logDebugFile("write handler");
+    return;
+  }
+  if (last) {
+    finish_body();
+  } else {
+    write_body_piece();
+  }
+}
+
+void Session::finish_body()
+{
+  body_stream_.reset();
+  body_buffer_ = BufferPool::Buffer();
+  continue_writing();
+}
+
+// Write whatever was queued behind a streamed body, or go back to reading
+void Session::continue_writing()
+{
+  if (!write_queue_.empty()) {
+    start_write();
+    return;
+  }
+  if (closing_) {
+    close_after_response();
+    return;
   }
-}
\ No newline at end of file
+  process_buffered_requests();
+}
+
+// End the connection after its last response. Closing with unread input
+// would make the kernel reset the connection, which can destroy the
+// response before the client reads it, so stop sending and drop what the
+// client still sends until it closes too, it sent too much, or the idle
+// timeout fires.
+void Session::close_after_response()
+{
+  boost::system::error_code ec;
+  socket_.shutdown(tcp::socket::shutdown_send, ec);
+  if (ec) {
+    socket_.close(ec);
+    return;
+  }
+  set_timeout(TimeoutPhase::Idle, options_.idle_timeout);
+  discard_input();
+}
+
+void Session::discard_input()
+{
+  static const size_t kMaxDiscardedBytes = 1024 * 1024;
+
+  if (!read_buffer_) {
+    read_buffer_ = buffer_pool_->acquire(BufferPool::kMaxBufferSize);
+  }
+  auto self = shared_from_this();
+  socket_.async_read_some(boost::asio::buffer(read_buffer_.data(), read_buffer_.size()),
+    boost::asio::bind_executor(strand_,
+      [self](const boost::system::error_code& error, size_t bytes_transferred) {
+        self->discarded_bytes_ += bytes_transferred;
+        if (error || self->discarded_bytes_ > kMaxDiscardedBytes) {
+          boost::system::error_code ec;
+          self->socket_.close(ec);
+          return;
+        }
+        self->discard_input();
+      }));
+}
+
+// Pick the deadline for the read about to start from where the request is
+void Session::update_read_deadline()
+{
+  if (parser_.buffered_bytes() == 0) {
+    set_timeout(TimeoutPhase::Idle, options_.idle_timeout);
+  } else if (parser_.state() == HttpRequestParser::State::Body) {
+    // Each read of the body restarts the clock
+    set_timeout(TimeoutPhase::Body, options_.body_timeout);
+  } else if (timeout_phase_ != TimeoutPhase::Header) {
+    // Headers get one deadline from their first byte, however slowly they trickle in
+    set_timeout(TimeoutPhase::Header, options_.header_timeout);
+  }
+}
+
+void Session::set_timeout(TimeoutPhase phase, std::chrono::seconds timeout)
+{
+  timeout_phase_ = phase;
+  if (!timer_wheel_) {
+    return;
+  }
+  if (timeout.count() == 0) {
+    timer_wheel_->clear_deadline(*this);
+    return;
+  }
+  timer_wheel_->set_deadline(shared_from_this(), TimerWheel::Clock::now() + timeout);
+}
+
+void Session::on_timeout()
+{
+  auto self = shared_from_this();
+  boost::asio::post(strand_, [self]() {
+    self->handle_timeout();
+  });
+}
+
+void Session::handle_timeout()
+{
+  // The connection may have made progress since the wheel fired
+  if (!timer_wheel_ || !timer_wheel_->expired(*this)) {
+    return;
+  }
+
+  Logger * logger = Logger::getLogger();
+  boost::system::error_code ec;
+
+  if (timeout_phase_ == TimeoutPhase::Idle || closing_) {
+    logger->logDebugFile("Closing idle connection");
+
+    // Fails the outstanding read, which drops the last reference to the session
+    socket_.shutdown(tcp::socket::shutdown_both, ec);
+    socket_.close(ec);
+    return;
+  }
+
+  logger->logDebugFile(std::string("Closing connection after ") +
+      (timeout_phase_ == TimeoutPhase::Header ? "header" : "body") + " read timeout");
+
+  // Nothing else is being written while a request is still being read, so
+  // the 408 goes out like any other final response: without blocking the
+  // strand on a client that does not read, and bounded by the idle timeout
+  // start_write() sets. The read in progress is cancelled, and whatever
+  // it or later reads bring is dropped.
+  socket_.cancel(ec);
+  std::string path(parser_.target());
+  parser_.reset();
+  body_handler_.reset();
+  body_sink_.reset();
+  body_handler_checked_ = false;
+  closing_ = true;
+  queue_response(HttpResponse("HTTP/1.1", 408, "Request Timeout",
+      {{"Content-Type", "text/plain"}, {"Connection", "close"}}, "Request Timeout"),
+      path, "RequestTimeout");
+  start_write();
+}
@@ -4,6 +4,7 @@
 
 SleepHandler::SleepHandler(int sleep_seconds)
     : sleep_seconds_(sleep_seconds) {
+    blocking_ = true;
 }
 
 HttpResponse SleepHandler::handle_request(const HttpRequest& request) {
@@ -0,0 +1,147 @@
+#include "stat_cache.h"
+#include <sys/stat.h>
+
+namespace {
+
+StatCache::Result to_result(const struct stat& st) {
+    StatCache::Result result;
+    result.exists = true;
+    result.regular = S_ISREG(st.st_mode);
+    result.inode = static_cast<uint64_t>(st.st_ino);
+    result.size = static_cast<uint64_t>(st.st_size);
+    result.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    return result;
+}
+
+}
+
+StatCache::StatCache(size_t max_entries, std::chrono::milliseconds ttl, Lookup lookup,
+                     std::shared_ptr<DirectoryWatcher> watcher)
+    : max_entries_(max_entries),
+      ttl_(ttl),
+      lookup_(lookup ? std::move(lookup) : Lookup(&StatCache::stat_uncached)),
+      watcher_(std::move(watcher)) {
+    subscription_ = watcher_->subscribe({[this](const std::string& path) { invalidate(path); },
+                                         [this](const std::string& directory) { invalidate(directory); },
+                                         [this]() { clear(); }});
+}
+
+// Before any member goes, as the callbacks touch them
+StatCache::~StatCache() {
+    watcher_->unsubscribe(subscription_);
+}
+
+StatCache::Result StatCache::stat_uncached(const std::string& path) {
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+        return Result();
+    }
+    return to_result(st);
+}
+
+StatCache::Result StatCache::stat_fd(int fd) {
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        return Result();
+    }
+    return to_result(st);
+}
+
+StatCache::Result StatCache::stat(const std::string& path) {
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(path);
+        if (it != entries_.end()) {
+            if (Clock::now() < it->second.expires) {
+                lru_.splice(lru_.begin(), lru_, it->second.lru);
+                ++hits_;
+                return it->second.result;
+            }
+            lru_.erase(it->second.lru);
+            entries_.erase(it);
+        }
+        generation = generation_;
+    }
+
+    // Watch before looking, so a change right after the stat() is seen.
+    // The first try assumes the path exists, which is the common case.
+    bool watched = watch_for(path, true);
+    Result result = lookup_(path);
+    if (!result.exists && !watched) {
+        watched = watch_for(path, false);
+    }
+
+    Clock::time_point expires = Clock::now() + ttl_;
+    if (!result.exists && watched) {
+        expires = Clock::time_point::max();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (max_entries_ == 0 || generation != generation_ || entries_.count(path)) {
+        return result;
+    }
+    lru_.push_front(path);
+    entries_[path] = Slot{result, expires, lru_.begin()};
+    while (entries_.size() > max_entries_) {
+        entries_.erase(lru_.back());
+        lru_.pop_back();
+    }
+    return result;
+}
+
+// A path that exists changes through an event in its directory. A missing
+// one can only appear once its missing ancestors are created, the first of
+// which shows up in the nearest directory that does exist.
+bool StatCache::watch_for(const std::string& path, bool exists) {
+    std::string directory = DirectoryWatcher::parent_directory(path);
+    if (exists) {
+        return watcher_->watch(subscription_, directory);
+    }
+    while (!watcher_->watch(subscription_, directory)) {
+        if (directory == "/" || directory == ".") {
+            return false;
+        }
+        directory = DirectoryWatcher::parent_directory(directory);
+    }
+    return true;
+}
+
+void StatCache::invalidate(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    invalidate_locked(path);
+}
+
+// Caller holds mutex_
+void StatCache::invalidate_locked(const std::string& path) {
+    ++generation_;
+    auto it = entries_.find(path);
+    if (it != entries_.end()) {
+        lru_.erase(it->second.lru);
+        entries_.erase(it);
+    }
+
+    std::string prefix = DirectoryWatcher::join_path(path, "");
+    for (it = entries_.lower_bound(prefix);
+         it != entries_.end() && it->first.compare(0, prefix.size(), prefix) == 0;) {
+        lru_.erase(it->second.lru);
+        it = entries_.erase(it);
+    }
+}
+
+void StatCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++generation_;
+    entries_.clear();
+    lru_.clear();
+}
+
+size_t StatCache::entries() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+uint64_t StatCache::hits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+}
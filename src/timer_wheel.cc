@@ -0,0 +1,120 @@
+#include "timer_wheel.h"
+#include <algorithm>
+
+TimerWheel::TimerWheel(boost::asio::io_service& io_service,
+                       std::chrono::milliseconds tick_duration, size_t num_slots)
+    : timer_(io_service), tick_duration_(tick_duration), base_(Clock::now()),
+      slots_(std::max<size_t>(num_slots, 2)) {}
+
+void TimerWheel::start() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = true;
+    }
+    schedule_tick();
+}
+
+void TimerWheel::stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+    timer_.cancel();
+}
+
+void TimerWheel::schedule_tick() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_) {
+        return;
+    }
+    timer_.expires_at(base_ + tick_duration_ * (current_tick_ + 1));
+    timer_.async_wait([this](const boost::system::error_code& error) {
+        if (error) {
+            return;
+        }
+        advance(Clock::now());
+        schedule_tick();
+    });
+}
+
+void TimerWheel::set_deadline(const std::shared_ptr<Client>& client, Clock::time_point deadline) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    client->deadline_ = deadline;
+
+    // A later deadline keeps the existing entry; it is re-slotted when it fires
+    if (client->scheduled_tick_ == 0 || tick_for(deadline) < client->scheduled_tick_) {
+        insert(client, deadline);
+    }
+}
+
+void TimerWheel::clear_deadline(Client& client) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    client.deadline_ = Clock::time_point::max();
+}
+
+bool TimerWheel::expired(const Client& client, Clock::time_point now) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return client.deadline_ <= now;
+}
+
+uint64_t TimerWheel::tick_for(Clock::time_point deadline) const {
+    uint64_t first = current_tick_ + 1;
+    uint64_t last = current_tick_ + slots_.size() - 1;
+    if (deadline <= base_) {
+        return first;
+    }
+
+    // Round up so an entry never fires before its deadline
+    auto offset = deadline - base_;
+    uint64_t tick = static_cast<uint64_t>((offset + tick_duration_ - Clock::duration(1)) / tick_duration_);
+
+    // Deadlines past the wheel's horizon park in its last slot and go round again
+    return std::clamp(tick, first, last);
+}
+
+void TimerWheel::insert(const std::shared_ptr<Client>& client, Clock::time_point deadline) {
+    uint64_t tick = tick_for(deadline);
+    slots_[tick % slots_.size()].push_back(Entry{client, tick});
+    client->scheduled_tick_ = tick;
+}
+
+void TimerWheel::advance(Clock::time_point now) {
+    std::vector<std::shared_ptr<Client>> due;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (base_ + tick_duration_ * (current_tick_ + 1) <= now) {
+            ++current_tick_;
+            std::vector<Entry> entries;
+            entries.swap(slots_[current_tick_ % slots_.size()]);
+
+            for (const Entry& entry : entries) {
+                std::shared_ptr<Client> client = entry.client.lock();
+                // Gone, or superseded by an entry for an earlier deadline
+                if (!client || client->scheduled_tick_ != entry.tick) {
+                    continue;
+                }
+                client->scheduled_tick_ = 0;
+
+                if (client->deadline_ == Clock::time_point::max()) {
+                    continue;
+                }
+                if (client->deadline_ <= now) {
+                    due.push_back(std::move(client));
+                } else {
+                    insert(client, client->deadline_);
+                }
+            }
+        }
+    }
+
+    for (const std::shared_ptr<Client>& client : due) {
+        client->on_timeout();
+    }
+}
+
+size_t TimerWheel::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t total = 0;
+    for (const std::vector<Entry>& slot : slots_) {
+        total += slot.size();
+    }
+    return total;
+}
@@ -0,0 +1,41 @@
+#include "blocking_executor.h"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+// Test: Submitted tasks run on the worker threads
+TEST(BlockingExecutorTest, RunsSubmittedTasks) {
+    std::atomic<int> runs{0};
+    {
+        BlockingExecutor executor(2);
+        for (int i = 0; i < 10; ++i) {
+            EXPECT_TRUE(executor.submit([&runs]() { ++runs; }));
+        }
+    }
+    // The destructor waits for queued work
+    EXPECT_EQ(runs.load(), 10);
+}
+
+// Test: Work beyond max_pending is refused until a slot frees up
+TEST(BlockingExecutorTest, RejectsWorkBeyondLimit) {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool release = false;
+    auto wait_for_release = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() { return release; });
+    };
+
+    BlockingExecutor executor(1, 2);
+    EXPECT_TRUE(executor.submit(wait_for_release));
+    EXPECT_TRUE(executor.submit(wait_for_release));
+    EXPECT_FALSE(executor.submit([]() {}));
+    EXPECT_EQ(executor.pending(), 2u);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        release = true;
+    }
+    cv.notify_all();
+}
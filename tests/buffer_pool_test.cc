@@ -0,0 +1,64 @@
+#include "buffer_pool.h"
+#include "gtest/gtest.h"
+
+class BufferPoolTest : public ::testing::Test {
+protected:
+    BufferPool pool_{2};
+};
+
+// Test: Requests are rounded up to a power-of-two size class
+TEST_F(BufferPoolTest, RoundsUpToSizeClass) {
+    EXPECT_EQ(BufferPool::size_class(1), BufferPool::kMinBufferSize);
+    EXPECT_EQ(BufferPool::size_class(1024), 1024u);
+    EXPECT_EQ(BufferPool::size_class(1025), 2048u);
+    EXPECT_EQ(BufferPool::size_class(10 * 1024 * 1024), BufferPool::kMaxBufferSize);
+
+    BufferPool::Buffer buffer = pool_.acquire(3000);
+    ASSERT_TRUE(buffer);
+    EXPECT_EQ(buffer.size(), 4096u);
+}
+
+// Test: Released buffers are handed out again
+TEST_F(BufferPoolTest, ReusesReleasedBuffers) {
+    char* first = nullptr;
+    {
+        BufferPool::Buffer buffer = pool_.acquire(1024);
+        first = buffer.data();
+    }
+    EXPECT_EQ(pool_.cached_buffers(), 1u);
+
+    BufferPool::Buffer again = pool_.acquire(1024);
+    EXPECT_EQ(again.data(), first);
+    EXPECT_EQ(pool_.cached_buffers(), 0u);
+}
+
+// Test: Size classes do not share free lists
+TEST_F(BufferPoolTest, DoesNotMixSizeClasses) {
+    { BufferPool::Buffer small = pool_.acquire(1024); }
+
+    BufferPool::Buffer large = pool_.acquire(8192);
+    EXPECT_EQ(large.size(), 8192u);
+    EXPECT_EQ(pool_.cached_buffers(), 1u);
+}
+
+// Test: The pool keeps at most max_cached_per_class idle buffers
+TEST_F(BufferPoolTest, CapsCachedBuffers) {
+    {
+        BufferPool::Buffer a = pool_.acquire(1024);
+        BufferPool::Buffer b = pool_.acquire(1024);
+        BufferPool::Buffer c = pool_.acquire(1024);
+    }
+    EXPECT_EQ(pool_.cached_buffers(), 2u);
+}
+
+// Test: Moving and resetting a handle returns the buffer exactly once
+TEST_F(BufferPoolTest, MoveTransfersOwnership) {
+    BufferPool::Buffer buffer = pool_.acquire(1024);
+    BufferPool::Buffer moved = std::move(buffer);
+    EXPECT_FALSE(buffer);
+    EXPECT_TRUE(moved);
+
+    moved = BufferPool::Buffer();
+    EXPECT_FALSE(moved);
+    EXPECT_EQ(pool_.cached_buffers(), 1u);
+}
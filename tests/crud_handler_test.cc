@@ -117,6 +117,20 @@ TEST_F(CrudHandlerTest, GetNonExistentEntityById) {
     EXPECT_EQ(response.get_message_body(), "Entity not found");
 }
 
+// Test: GET for an entity deleted between the existence check and the read
+// (by a concurrent request) is a 404, not an exception
+TEST_F(CrudHandlerTest, GetEntityDeletedMidRequest) {
+    // Claims every entity exists, as if it were deleted right after
+    class VanishingFilesystem : public MockFilesystem {
+    public:
+        bool entity_exists(const Entity&, const std::string&) const override { return true; }
+    };
+    CrudHandler handler("/api", std::make_shared<VanishingFilesystem>());
+
+    HttpResponse response = handler.handle_request(create_get_request("/api/Shoes/1"));
+    EXPECT_EQ(response.get_status_code(), 404);
+}
+
 // Test: GET request for different entity type with same ID
 TEST_F(CrudHandlerTest, GetDifferentEntityTypeWithSameId) {
     HttpRequest request = create_get_request("/api/Books/1");
@@ -1105,6 +1119,49 @@ TEST_F(CrudHandlerTest, DeleteThenRecreateSameId) {
     EXPECT_EQ(get_after_response.get_message_body(), new_data);
 }
 
+// Test: A POST body handed over in pieces is stored whole
+TEST_F(CrudHandlerTest, StreamedPostBodyIsStored) {
+    HttpRequest head = create_post_request("/api/Shoes");
+    std::unique_ptr<BodySink> sink = handler_->begin_body(head);
+    ASSERT_NE(sink, nullptr);
+    sink->write("{\"name\": ");
+    sink->write("\"Streamed\"");
+    sink->write("}");
+
+    HttpResponse response = handler_->handle_streamed_request(head, *sink);
+    EXPECT_EQ(response.get_status_code(), 201);
+    EXPECT_EQ(response.get_message_body(), "{\"id\": 3}");
+    EXPECT_EQ(filesystem_->read_entity(Entity("Shoes"), "3"), "{\"name\": \"Streamed\"}");
+}
+
+// Test: Streamed PUT bodies replace the entity; sinks of concurrent requests stay apart
+TEST_F(CrudHandlerTest, StreamedBodiesDoNotMix) {
+    HttpRequest first = create_put_request("/api/Shoes/1");
+    HttpRequest second = create_put_request("/api/Shoes/2");
+    std::unique_ptr<BodySink> first_sink = handler_->begin_body(first);
+    std::unique_ptr<BodySink> second_sink = handler_->begin_body(second);
+    first_sink->write("{\"size\": ");
+    second_sink->write("{\"size\": ");
+    first_sink->write("41}");
+    second_sink->write("42}");
+
+    EXPECT_EQ(handler_->handle_streamed_request(second, *second_sink).get_status_code(), 200);
+    EXPECT_EQ(handler_->handle_streamed_request(first, *first_sink).get_status_code(), 200);
+    EXPECT_EQ(filesystem_->read_entity(Entity("Shoes"), "1"), "{\"size\": 41}");
+    EXPECT_EQ(filesystem_->read_entity(Entity("Shoes"), "2"), "{\"size\": 42}");
+}
+
+// Test: Methods without a body ignore a streamed one
+TEST_F(CrudHandlerTest, StreamedBodyIgnoredForGet) {
+    HttpRequest head = create_get_request("/api/Shoes/1");
+    std::unique_ptr<BodySink> sink = handler_->begin_body(head);
+    sink->write("ignored");
+
+    HttpResponse response = handler_->handle_streamed_request(head, *sink);
+    EXPECT_EQ(response.get_status_code(), 200);
+    EXPECT_EQ(response.get_message_body(), "{\"name\": \"Nike Running Shoes\", \"price\": 99.99}");
+}
+
 // Test: List all without filters
 TEST_F(CrudHandlerFilterTest, ListAllWithoutFilters) {
     HttpRequest request;
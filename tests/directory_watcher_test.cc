@@ -0,0 +1,113 @@
+#include "directory_watcher.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <string>
+
+namespace fs = std::filesystem;
+
+class DirectoryWatcherTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        fs::create_directories(dir_ + "/sub");
+    }
+
+    void TearDown() override {
+        fs::remove_all(dir_);
+    }
+
+    DirectoryWatcher::Callbacks record(std::set<std::string>& changed) {
+        return {[this, &changed](const std::string& path) { add(changed, path); },
+                [this](const std::string& directory) { add(removed_, directory); },
+                []() {}};
+    }
+
+    DirectoryWatcher::Callbacks record() { return record(changed_); }
+
+    void add(std::set<std::string>& paths, const std::string& path) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        paths.insert(path);
+        cv_.notify_all();
+    }
+
+    bool wait_for(const std::set<std::string>& paths, const std::string& path) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, std::chrono::seconds(2), [&]() { return paths.count(path) > 0; });
+    }
+
+    std::string dir_ = "./directory_watcher_test_files";
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::set<std::string> changed_;
+    std::set<std::string> removed_;
+};
+
+// Test: Writes to a name in a watched directory are reported with its path
+TEST_F(DirectoryWatcherTest, ReportsChangedNames) {
+    DirectoryWatcher watcher;
+    ASSERT_TRUE(watcher.active());
+    DirectoryWatcher::Subscription subscription = watcher.subscribe(record());
+    ASSERT_TRUE(watcher.watch(subscription, dir_));
+    EXPECT_TRUE(watcher.watch(subscription, dir_));
+    EXPECT_FALSE(watcher.watch(subscription, dir_ + "/missing"));
+
+    std::ofstream(dir_ + "/a.txt") << "hello";
+    EXPECT_TRUE(wait_for(changed_, dir_ + "/a.txt"));
+}
+
+// Test: A watched directory that is removed is reported as such
+TEST_F(DirectoryWatcherTest, ReportsRemovedDirectories) {
+    DirectoryWatcher watcher;
+    DirectoryWatcher::Subscription subscription = watcher.subscribe(record());
+    ASSERT_TRUE(watcher.watch(subscription, dir_ + "/sub"));
+
+    fs::remove(dir_ + "/sub");
+    EXPECT_TRUE(wait_for(removed_, dir_ + "/sub"));
+}
+
+// Test: Subscribers share watches but only hear about their own directories
+TEST_F(DirectoryWatcherTest, RoutesEventsToSubscribers) {
+    DirectoryWatcher watcher;
+    std::set<std::string> other_changed;
+    DirectoryWatcher::Subscription first = watcher.subscribe(record());
+    DirectoryWatcher::Subscription second = watcher.subscribe(record(other_changed));
+    ASSERT_TRUE(watcher.watch(first, dir_));
+    ASSERT_TRUE(watcher.watch(second, dir_));
+    ASSERT_TRUE(watcher.watch(second, dir_ + "/sub"));
+    EXPECT_EQ(watcher.watches(), 2u);
+
+    std::ofstream(dir_ + "/sub/b.txt") << "hello";
+    std::ofstream(dir_ + "/a.txt") << "hello";
+    EXPECT_TRUE(wait_for(changed_, dir_ + "/a.txt"));
+    EXPECT_TRUE(wait_for(other_changed, dir_ + "/a.txt"));
+    EXPECT_TRUE(wait_for(other_changed, dir_ + "/sub/b.txt"));
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        EXPECT_EQ(changed_.count(dir_ + "/sub/b.txt"), 0u);
+    }
+
+    // A watch goes once no subscriber needs it any more
+    watcher.unsubscribe(second);
+    EXPECT_EQ(watcher.watches(), 1u);
+    watcher.unsubscribe(first);
+    EXPECT_EQ(watcher.watches(), 0u);
+}
+
+// Test: Every user of the shared watcher gets the same one while it lives
+TEST_F(DirectoryWatcherTest, SharesOneWatcher) {
+    std::shared_ptr<DirectoryWatcher> watcher = DirectoryWatcher::shared();
+    EXPECT_EQ(DirectoryWatcher::shared(), watcher);
+}
+
+// Test: Path helpers
+TEST_F(DirectoryWatcherTest, SplitsAndJoinsPaths) {
+    EXPECT_EQ(DirectoryWatcher::parent_directory("/srv/www/a.html"), "/srv/www");
+    EXPECT_EQ(DirectoryWatcher::parent_directory("/a.html"), "/");
+    EXPECT_EQ(DirectoryWatcher::parent_directory("a.html"), ".");
+    EXPECT_EQ(DirectoryWatcher::join_path("/srv/www", "a.html"), "/srv/www/a.html");
+    EXPECT_EQ(DirectoryWatcher::join_path("/", "a.html"), "/a.html");
+}
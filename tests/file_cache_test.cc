@@ -0,0 +1,133 @@
+#include "file_cache.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+class FileCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        fs::create_directories(dir_);
+    }
+
+    void TearDown() override {
+        fs::remove_all(dir_);
+    }
+
+    std::string write_file(const std::string& name, const std::string& content) {
+        std::string path = dir_ + "/" + name;
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << content;
+        return path;
+    }
+
+    // Entry for path as a handler would build it after reading the file
+    std::shared_ptr<FileCache::Entry> make_entry(const std::string& path, const std::string& content) {
+        auto entry = std::make_shared<FileCache::Entry>();
+        EXPECT_TRUE(FileCache::stat_file(path, entry->mtime_ns, entry->size));
+        entry->body = content;
+        entry->headers = {{"Content-Type", "text/plain"}};
+        return entry;
+    }
+
+    // The watcher drops entries asynchronously
+    bool wait_until_evicted(FileCache& cache, const std::string& path) {
+        for (int i = 0; i < 200; ++i) {
+            if (!cache.lookup(path)) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    }
+
+    std::string dir_ = "./file_cache_test_files";
+};
+
+// Test: An inserted file is returned with its headers
+TEST_F(FileCacheTest, ReturnsInsertedEntry) {
+    FileCache cache(1024);
+    ASSERT_TRUE(cache.watching());
+    std::string path = write_file("a.txt", "hello");
+
+    EXPECT_EQ(cache.lookup(path), nullptr);
+    cache.insert(path, make_entry(path, "hello"));
+
+    auto entry = cache.lookup(path);
+    ASSERT_NE(entry, nullptr);
+    EXPECT_EQ(entry->body, "hello");
+    EXPECT_EQ(entry->headers.at("Content-Type"), "text/plain");
+    EXPECT_EQ(cache.bytes(), 5u);
+}
+
+// Test: The least recently used files are evicted to stay within budget
+TEST_F(FileCacheTest, EvictsLeastRecentlyUsed) {
+    FileCache cache(10);
+    std::string a = write_file("a.txt", "aaaa");
+    std::string b = write_file("b.txt", "bbbb");
+    std::string c = write_file("c.txt", "cccc");
+
+    cache.insert(a, make_entry(a, "aaaa"));
+    cache.insert(b, make_entry(b, "bbbb"));
+    ASSERT_NE(cache.lookup(a), nullptr);  // b is now the oldest
+    cache.insert(c, make_entry(c, "cccc"));
+
+    EXPECT_NE(cache.lookup(a), nullptr);
+    EXPECT_EQ(cache.lookup(b), nullptr);
+    EXPECT_NE(cache.lookup(c), nullptr);
+    EXPECT_EQ(cache.entries(), 2u);
+    EXPECT_EQ(cache.bytes(), 8u);
+}
+
+// Test: Files larger than the whole budget are not cached
+TEST_F(FileCacheTest, SkipsOversizedFiles) {
+    FileCache cache(4);
+    std::string path = write_file("big.txt", "too large");
+
+    cache.insert(path, make_entry(path, "too large"));
+    EXPECT_EQ(cache.lookup(path), nullptr);
+    EXPECT_EQ(cache.bytes(), 0u);
+}
+
+// Test: Contents read before the file changed are not cached
+TEST_F(FileCacheTest, RejectsStaleEntry) {
+    FileCache cache(1024);
+    std::string path = write_file("a.txt", "old");
+    auto entry = make_entry(path, "old");
+
+    write_file("a.txt", "newer");
+    cache.insert(path, entry);
+    EXPECT_EQ(cache.lookup(path), nullptr);
+}
+
+// Test: Writing a cached file invalidates it
+TEST_F(FileCacheTest, InvalidatesOnWrite) {
+    FileCache cache(1024);
+    std::string path = write_file("a.txt", "old");
+    cache.insert(path, make_entry(path, "old"));
+    ASSERT_NE(cache.lookup(path), nullptr);
+
+    write_file("a.txt", "new");
+    EXPECT_TRUE(wait_until_evicted(cache, path));
+}
+
+// Test: Removing or renaming over a cached file invalidates it
+TEST_F(FileCacheTest, InvalidatesOnDeleteAndRename) {
+    FileCache cache(1024);
+    std::string a = write_file("a.txt", "a");
+    std::string b = write_file("b.txt", "b");
+    cache.insert(a, make_entry(a, "a"));
+    cache.insert(b, make_entry(b, "b"));
+
+    fs::remove(a);
+    EXPECT_TRUE(wait_until_evicted(cache, a));
+
+    std::string replacement = write_file("b.tmp", "replaced");
+    fs::rename(replacement, b);
+    EXPECT_TRUE(wait_until_evicted(cache, b));
+}
@@ -8,6 +8,11 @@
 #include <filesystem>
 #include <fstream>
 #include <unordered_set>
+#include <chrono>
+#include <thread>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
 
 namespace fs = std::filesystem;
 
@@ -229,6 +234,56 @@ TEST_F(FileHandlerTest, PreventMultipleDirectoryTraversal) {
     EXPECT_EQ(response.get_status_code(), 404);
 }
 
+// Test: Symlinks that lead out of the root are refused, with or without the
+// caches, while ones that stay inside it still work
+TEST_F(FileHandlerTest, SymlinksCannotLeaveRoot) {
+    std::string outside = fs::absolute(test_dir_ + "_outside.html").string();
+    {
+        std::ofstream file(outside);
+        file << "<p>secret</p>";
+    }
+    fs::create_symlink(outside, test_dir_ + "/absolute.html");
+    fs::create_symlink("../" + fs::path(outside).filename().string(), test_dir_ + "/relative.html");
+    fs::create_symlink("subdir/nested.html", test_dir_ + "/inside.html");
+
+    for (int caches = 0; caches < 2; ++caches) {
+        FileHandler handler(test_dir_, route_prefix_);
+        if (caches) {
+            handler.enable_cache(1 << 20);
+            handler.enable_stat_cache(64);
+        }
+        EXPECT_EQ(handler.handle_request(create_request("/static/absolute.html")).get_status_code(), 404);
+        EXPECT_EQ(handler.handle_request(create_request("/static/relative.html")).get_status_code(), 404);
+
+        HttpResponse response = handler.handle_request(create_request("/static/inside.html"));
+        EXPECT_EQ(response.get_status_code(), 200);
+        EXPECT_EQ(response.get_message_body(), "<html>Nested</html>");
+    }
+    fs::remove(outside);
+}
+
+// Test: With only the stat cache, a symlink out of the root reveals nothing
+// about its target: no 415 for its type and no 304 for its timestamp
+TEST_F(FileHandlerTest, StatCacheStaysInsideRoot) {
+    std::string outside = fs::absolute(test_dir_ + "_outside.html").string();
+    std::string outside_binary = fs::absolute(test_dir_ + "_outside.bin").string();
+    std::ofstream(outside) << "<p>secret</p>";
+    std::ofstream(outside_binary) << "secret";
+    fs::create_symlink(outside, test_dir_ + "/secret.html");
+    fs::create_symlink(outside_binary, test_dir_ + "/secret.bin");
+
+    FileHandler handler(test_dir_, route_prefix_);
+    handler.enable_stat_cache(64);
+
+    HttpRequest conditional = create_request("/static/secret.html");
+    conditional.add_header("If-Modified-Since", "Fri, 01 Jan 2100 00:00:00 GMT");
+    EXPECT_EQ(handler.handle_request(conditional).get_status_code(), 404);
+    EXPECT_EQ(handler.handle_request(create_request("/static/secret.bin")).get_status_code(), 404);
+
+    fs::remove(outside);
+    fs::remove(outside_binary);
+}
+
 // Test: Path with . components
 TEST_F(FileHandlerTest, PathWithDotComponents) {
     FileHandler handler(test_dir_, route_prefix_);
@@ -330,6 +385,88 @@ TEST_F(FileHandlerTest, LargeFile) {
     EXPECT_EQ(response.get_message_body().length(), 10000);
 }
 
+// Test: Files over the stream threshold are streamed, not loaded
+TEST_F(FileHandlerTest, StreamsFileOverThreshold) {
+    std::string large_content(10000, 'A');
+    large_content += "END";
+    create_test_file("large.txt", large_content);
+
+    FileHandler handler(test_dir_, route_prefix_);
+    handler.set_stream_threshold(4096);
+    HttpResponse response = handler.handle_request(create_request("/static/large.txt"));
+
+    EXPECT_EQ(response.get_status_code(), 200);
+    EXPECT_EQ(response.get_message_body(), "");
+    EXPECT_EQ(response.get_header("Content-Length"), "10003");
+    ASSERT_NE(response.get_body_stream(), nullptr);
+
+    std::string streamed;
+    char buffer[4096];
+    while (size_t n = response.get_body_stream()->read(buffer, sizeof(buffer))) {
+        streamed.append(buffer, n);
+    }
+    EXPECT_EQ(streamed, large_content);
+}
+
+// Test: Files over the mmap threshold share one mapping across requests
+TEST_F(FileHandlerTest, ServesMappedFiles) {
+    std::string large_content(10000, 'A');
+    large_content += "END";
+    create_test_file("large.txt", large_content);
+
+    FileHandler handler(test_dir_, route_prefix_);
+    handler.enable_mmap(4096);
+    ASSERT_NE(handler.mappings(), nullptr);
+
+    HttpResponse first = handler.handle_request(create_request("/static/large.txt"));
+    HttpResponse second = handler.handle_request(create_request("/static/large.txt"));
+    ASSERT_NE(dynamic_cast<MappedBody*>(first.get_body_stream().get()), nullptr);
+    ASSERT_NE(dynamic_cast<MappedBody*>(second.get_body_stream().get()), nullptr);
+    EXPECT_EQ(first.get_header("Content-Length"), "10003");
+    EXPECT_EQ(handler.mappings()->mapped_files(), 1u);
+
+    std::string streamed;
+    char buffer[4096];
+    while (size_t n = first.get_body_stream()->read(buffer, sizeof(buffer))) {
+        streamed.append(buffer, n);
+    }
+    EXPECT_EQ(streamed, large_content);
+
+    HttpRequest range = create_request("/static/large.txt");
+    range.add_header("Range", "bytes=-3");
+    HttpResponse partial = handler.handle_request(range);
+    EXPECT_EQ(partial.get_status_code(), 206);
+    auto* mapped = dynamic_cast<MappedBody*>(partial.get_body_stream().get());
+    ASSERT_NE(mapped, nullptr);
+    EXPECT_EQ(mapped->next_span(16), "END");
+
+    // Small files are still read into the response
+    HttpResponse small = handler.handle_request(create_request("/static/index.html"));
+    EXPECT_EQ(small.get_body_stream(), nullptr);
+    EXPECT_EQ(small.get_message_body(), "<html><body>Hello World</body></html>");
+}
+
+// Test: With a stat cache, repeated probes for a missing file get their 404
+// from memory, until the file is created
+TEST_F(FileHandlerTest, StatCacheAnswersMissingFiles) {
+    FileHandler handler(test_dir_, route_prefix_);
+    handler.enable_stat_cache(64);
+    ASSERT_NE(handler.stat_cache(), nullptr);
+
+    EXPECT_EQ(handler.handle_request(create_request("/static/ghost.html")).get_status_code(), 404);
+    uint64_t hits = handler.stat_cache()->hits();
+    EXPECT_EQ(handler.handle_request(create_request("/static/ghost.html")).get_status_code(), 404);
+    EXPECT_EQ(handler.stat_cache()->hits(), hits + 1);
+
+    create_test_file("ghost.html", "<p>boo</p>");
+    int status = 404;
+    for (int i = 0; i < 200 && status == 404; ++i) {
+        status = handler.handle_request(create_request("/static/ghost.html")).get_status_code();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(status, 200);
+}
+
 // Test: Empty file
 TEST_F(FileHandlerTest, EmptyFile) {
     create_test_file("empty.txt", "");
@@ -466,4 +603,266 @@ TEST_F(FileHandlerTest, OnlyQuestionMark) {
     
     EXPECT_EQ(response.get_status_code(), 200);
     EXPECT_EQ(response.get_header("Content-Type"), "image/png");
-}
\ No newline at end of file
+}
+// Test: Cached files are served from memory until they change on disk
+TEST_F(FileHandlerTest, CachesFilesUntilTheyChange) {
+    FileHandler handler(test_dir_, route_prefix_);
+    handler.enable_cache(1024 * 1024);
+    ASSERT_NE(handler.cache(), nullptr);
+
+    HttpResponse first = handler.handle_request(create_request("/static/index.html"));
+    EXPECT_EQ(first.get_status_code(), 200);
+    EXPECT_EQ(handler.cache()->entries(), 1u);
+
+    HttpResponse cached = handler.handle_request(create_request("/static/index.html"));
+    EXPECT_EQ(cached.get_message_body(), first.get_message_body());
+    EXPECT_EQ(cached.get_header("Content-Type"), "text/html");
+
+    create_test_file("index.html", "<html>Changed</html>");
+    std::string body;
+    for (int i = 0; i < 200 && body != "<html>Changed</html>"; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        body = handler.handle_request(create_request("/static/index.html")).get_message_body();
+    }
+    EXPECT_EQ(body, "<html>Changed</html>");
+}
+
+// Test: Precompressed siblings are preferred when the client accepts them
+TEST_F(FileHandlerTest, ServesPrecompressedSiblings) {
+    create_test_file("index.html.br", "brotli bytes");
+    create_test_file("index.html.gz", "gzip bytes");
+    FileHandler handler(test_dir_, route_prefix_);
+
+    HttpRequest request = create_request("/static/index.html");
+    request.add_header("Accept-Encoding", "gzip, br");
+    HttpResponse response = handler.handle_request(request);
+    EXPECT_EQ(response.get_message_body(), "brotli bytes");
+    EXPECT_EQ(response.get_header("Content-Encoding"), "br");
+    EXPECT_EQ(response.get_header("Content-Type"), "text/html");
+    EXPECT_EQ(response.get_header("Vary"), "Accept-Encoding");
+
+    HttpRequest gzip_request = create_request("/static/index.html");
+    gzip_request.add_header("Accept-Encoding", "gzip");
+    EXPECT_EQ(handler.handle_request(gzip_request).get_message_body(), "gzip bytes");
+
+    HttpResponse identity = handler.handle_request(create_request("/static/index.html"));
+    EXPECT_EQ(identity.get_message_body(), "<html><body>Hello World</body></html>");
+    EXPECT_EQ(identity.get_header("Content-Encoding"), "");
+    EXPECT_EQ(identity.get_header("Vary"), "Accept-Encoding");
+}
+
+// Test: A cached entry picks up a sibling created later
+TEST_F(FileHandlerTest, CachedEntrySeesNewSibling) {
+    FileHandler handler(test_dir_, route_prefix_);
+    handler.enable_cache(1024 * 1024);
+
+    HttpRequest request = create_request("/static/style.css");
+    request.add_header("Accept-Encoding", "br");
+    EXPECT_EQ(handler.handle_request(request).get_header("Content-Encoding"), "");
+    ASSERT_EQ(handler.cache()->entries(), 1u);
+
+    create_test_file("style.css.br", "brotli css");
+    std::string body;
+    for (int i = 0; i < 200 && body != "brotli css"; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        body = handler.handle_request(request).get_message_body();
+    }
+    EXPECT_EQ(body, "brotli css");
+}
+
+#ifdef HAVE_ZLIB
+// Test: Compressible files are gzipped once when cached
+TEST_F(FileHandlerTest, GzipsCachedTextFiles) {
+    std::string text;
+    for (int i = 0; i < 100; ++i) {
+        text += "line " + std::to_string(i) + " of some very repetitive text\n";
+    }
+    create_test_file("long.txt", text);
+    FileHandler handler(test_dir_, route_prefix_);
+    handler.enable_cache(1024 * 1024);
+
+    HttpRequest request = create_request("/static/long.txt");
+    request.add_header("Accept-Encoding", "gzip");
+    HttpResponse response = handler.handle_request(request);
+    EXPECT_EQ(response.get_header("Content-Encoding"), "gzip");
+    EXPECT_EQ(response.get_header("Vary"), "Accept-Encoding");
+    const std::string& compressed = response.get_message_body();
+    ASSERT_LT(compressed.size(), text.size());
+
+    z_stream stream{};
+    ASSERT_EQ(inflateInit2(&stream, 15 + 16), Z_OK);
+    std::string inflated(text.size() + 1, '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+    stream.avail_in = compressed.size();
+    stream.next_out = reinterpret_cast<Bytef*>(&inflated[0]);
+    stream.avail_out = inflated.size();
+    EXPECT_EQ(inflate(&stream, Z_FINISH), Z_STREAM_END);
+    inflated.resize(stream.total_out);
+    inflateEnd(&stream);
+    EXPECT_EQ(inflated, text);
+
+    // Clients that do not ask for it still get the file as is
+    EXPECT_EQ(handler.handle_request(create_request("/static/long.txt")).get_message_body(), text);
+}
+#endif
+
+// Test: Responses carry validators and matching If-None-Match gets a 304
+TEST_F(FileHandlerTest, AnswersIfNoneMatchWith304) {
+    FileHandler handler(test_dir_, route_prefix_);
+    HttpResponse first = handler.handle_request(create_request("/static/index.html"));
+    std::string etag = first.get_header("ETag");
+    ASSERT_FALSE(etag.empty());
+    EXPECT_EQ(etag.front(), '"');
+    EXPECT_FALSE(first.get_header("Last-Modified").empty());
+
+    HttpRequest request = create_request("/static/index.html");
+    request.add_header("If-None-Match", "\"other\", " + etag);
+    HttpResponse response = handler.handle_request(request);
+    EXPECT_EQ(response.get_status_code(), 304);
+    EXPECT_EQ(response.get_reason_phrase(), "Not Modified");
+    EXPECT_EQ(response.get_message_body(), "");
+    EXPECT_EQ(response.get_header("Content-Length"), "");
+    EXPECT_EQ(response.get_header("ETag"), etag);
+
+    create_test_file("index.html", "<html>Changed length</html>");
+    EXPECT_EQ(handler.handle_request(request).get_status_code(), 200);
+}
+
+// Test: If-Modified-Since is compared against the file's mtime
+TEST_F(FileHandlerTest, AnswersIfModifiedSince) {
+    FileHandler handler(test_dir_, route_prefix_);
+    std::string last_modified =
+        handler.handle_request(create_request("/static/style.css")).get_header("Last-Modified");
+
+    HttpRequest unchanged = create_request("/static/style.css");
+    unchanged.add_header("If-Modified-Since", last_modified);
+    EXPECT_EQ(handler.handle_request(unchanged).get_status_code(), 304);
+
+    HttpRequest stale = create_request("/static/style.css");
+    stale.add_header("If-Modified-Since", "Sun, 06 Nov 1994 08:49:37 GMT");
+    EXPECT_EQ(handler.handle_request(stale).get_status_code(), 200);
+
+    // If-None-Match takes precedence
+    HttpRequest both = create_request("/static/style.css");
+    both.add_header("If-None-Match", "\"nope\"");
+    both.add_header("If-Modified-Since", last_modified);
+    EXPECT_EQ(handler.handle_request(both).get_status_code(), 200);
+}
+
+// Test: Cached and encoded representations have their own validators
+TEST_F(FileHandlerTest, ValidatorsPerRepresentation) {
+    create_test_file("index.html.br", "brotli bytes");
+    FileHandler handler(test_dir_, route_prefix_);
+    handler.enable_cache(1024 * 1024);
+
+    HttpRequest br_request = create_request("/static/index.html");
+    br_request.add_header("Accept-Encoding", "br");
+    std::string br_etag = handler.handle_request(br_request).get_header("ETag");
+    std::string etag = handler.handle_request(create_request("/static/index.html")).get_header("ETag");
+    EXPECT_NE(br_etag, etag);
+
+    br_request.add_header("If-None-Match", br_etag);
+    EXPECT_EQ(handler.handle_request(br_request).get_status_code(), 304);
+
+    HttpRequest identity = create_request("/static/index.html");
+    identity.add_header("If-None-Match", br_etag);
+    EXPECT_EQ(handler.handle_request(identity).get_status_code(), 200);
+}
+
+// Test: A single range is answered with 206 and just those bytes
+TEST_F(FileHandlerTest, ServesSingleRange) {
+    create_test_file("digits.txt", "0123456789");
+    for (size_t threshold : {size_t(4), FileHandler::kDefaultStreamThreshold}) {
+        FileHandler handler(test_dir_, route_prefix_);
+        handler.set_stream_threshold(threshold);
+        HttpRequest request = create_request("/static/digits.txt");
+        request.add_header("Range", "bytes=2-5");
+        HttpResponse response = handler.handle_request(request);
+
+        EXPECT_EQ(response.get_status_code(), 206);
+        EXPECT_EQ(response.get_header("Content-Range"), "bytes 2-5/10");
+        EXPECT_EQ(response.get_header("Content-Length"), "4");
+        std::string body = response.get_message_body();
+        if (response.get_body_stream()) {
+            char buffer[16];
+            while (size_t n = response.get_body_stream()->read(buffer, sizeof(buffer))) {
+                body.append(buffer, n);
+            }
+        }
+        EXPECT_EQ(body, "2345");
+    }
+}
+
+// Test: Cache hits reuse the response head serialized when the file was cached
+TEST_F(FileHandlerTest, CacheHitsArePrepared) {
+    FileHandler handler(test_dir_, route_prefix_);
+    handler.enable_cache(1024);
+    HttpResponse first = handler.handle_request(create_request("/static/index.html"));
+    HttpResponse second = handler.handle_request(create_request("/static/index.html"));
+
+    ASSERT_TRUE(second.is_prepared());
+    EXPECT_EQ(second.convert_to_string(), first.convert_to_string());
+    EXPECT_EQ(second.get_header("Content-Length"), "37");
+    EXPECT_EQ(second.get_header("ETag"), first.get_header("ETag"));
+    EXPECT_EQ(second.get_message_body(), "<html><body>Hello World</body></html>");
+
+    // Each encoding has its own prepared head
+    create_test_file("style.css.gz", "gzipped-css");
+    HttpRequest gzip = create_request("/static/style.css");
+    gzip.add_header("Accept-Encoding", "gzip");
+    handler.handle_request(gzip);
+    HttpResponse encoded = handler.handle_request(gzip);
+    ASSERT_TRUE(encoded.is_prepared());
+    EXPECT_EQ(encoded.get_header("Content-Encoding"), "gzip");
+    EXPECT_EQ(encoded.get_header("Content-Length"), "11");
+    EXPECT_EQ(encoded.get_message_body(), "gzipped-css");
+}
+
+// Test: Several ranges become a multipart/byteranges body
+TEST_F(FileHandlerTest, ServesMultipartRanges) {
+    create_test_file("digits.txt", "0123456789");
+    FileHandler handler(test_dir_, route_prefix_);
+    handler.enable_cache(1024);
+    HttpRequest request = create_request("/static/digits.txt");
+    request.add_header("Range", "bytes=0-1, -2");
+
+    for (int pass = 0; pass < 2; ++pass) {  // fills the cache, then hits it
+        HttpResponse response = handler.handle_request(request);
+        EXPECT_EQ(response.get_status_code(), 206);
+        std::string content_type = response.get_header("Content-Type");
+        ASSERT_EQ(content_type.rfind("multipart/byteranges; boundary=", 0), 0u);
+        std::string boundary = content_type.substr(content_type.find('=') + 1);
+
+        EXPECT_EQ(response.get_message_body(),
+                  "\r\n--" + boundary + "\r\nContent-Type: text/plain\r\nContent-Range: bytes 0-1/10\r\n\r\n01"
+                  "\r\n--" + boundary + "\r\nContent-Type: text/plain\r\nContent-Range: bytes 8-9/10\r\n\r\n89"
+                  "\r\n--" + boundary + "--\r\n");
+    }
+}
+
+// Test: Unsatisfiable ranges get 416 and a stale If-Range gets the whole file
+TEST_F(FileHandlerTest, RangeEdgeCases) {
+    create_test_file("digits.txt", "0123456789");
+    FileHandler handler(test_dir_, route_prefix_);
+
+    HttpRequest beyond = create_request("/static/digits.txt");
+    beyond.add_header("Range", "bytes=10-20");
+    HttpResponse response = handler.handle_request(beyond);
+    EXPECT_EQ(response.get_status_code(), 416);
+    EXPECT_EQ(response.get_header("Content-Range"), "bytes */10");
+
+    HttpResponse full = handler.handle_request(create_request("/static/digits.txt"));
+    EXPECT_EQ(full.get_header("Accept-Ranges"), "bytes");
+
+    HttpRequest current = create_request("/static/digits.txt");
+    current.add_header("Range", "bytes=0-0");
+    current.add_header("If-Range", full.get_header("ETag"));
+    EXPECT_EQ(handler.handle_request(current).get_status_code(), 206);
+
+    HttpRequest stale = create_request("/static/digits.txt");
+    stale.add_header("Range", "bytes=0-0");
+    stale.add_header("If-Range", "\"old-version\"");
+    HttpResponse whole = handler.handle_request(stale);
+    EXPECT_EQ(whole.get_status_code(), 200);
+    EXPECT_EQ(whole.get_message_body(), "0123456789");
+}
@@ -0,0 +1,98 @@
+#include "file_reader.h"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <cerrno>
+#include <fcntl.h>
+#include <future>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+class FileReaderTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::ofstream file(path_, std::ios::binary | std::ios::trunc);
+        file << "0123456789";
+        file.close();
+        fd_ = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+        ASSERT_GE(fd_, 0);
+    }
+
+    void TearDown() override {
+        ::close(fd_);
+        ::unlink(path_.c_str());
+    }
+
+    // Issues one read and waits for its completion
+    ssize_t read_sync(FileReader& reader, int fd, uint64_t offset, char* data, size_t length) {
+        auto promise = std::make_shared<std::promise<ssize_t>>();
+        std::future<ssize_t> result = promise->get_future();
+        EXPECT_TRUE(reader.read(fd, offset, data, length, [promise](ssize_t n) {
+            promise->set_value(n);
+        }));
+        return result.get();
+    }
+
+    void check_reads(FileReader& reader) {
+        char buffer[16] = {};
+        ASSERT_EQ(read_sync(reader, fd_, 3, buffer, 4), 4);
+        EXPECT_EQ(std::string(buffer, 4), "3456");
+        EXPECT_EQ(read_sync(reader, fd_, 8, buffer, sizeof(buffer)), 2);
+        EXPECT_EQ(read_sync(reader, fd_, 10, buffer, sizeof(buffer)), 0);
+        EXPECT_EQ(read_sync(reader, -1, 0, buffer, sizeof(buffer)), -EBADF);
+    }
+
+    std::string path_ = "./file_reader_test.txt";
+    int fd_ = -1;
+};
+
+// Test: The executor backend reads with pread()
+TEST_F(FileReaderTest, ThreadedBackendReads) {
+    std::shared_ptr<FileReader> reader = FileReader::create_threaded(std::make_shared<BlockingExecutor>(2));
+    EXPECT_STREQ(reader->backend(), "threads");
+    check_reads(*reader);
+}
+
+// Test: The io_uring backend reads through the ring
+TEST_F(FileReaderTest, IoUringBackendReads) {
+    std::shared_ptr<FileReader> reader = FileReader::create_io_uring(8);
+    if (!reader) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    EXPECT_STREQ(reader->backend(), "io_uring");
+    check_reads(*reader);
+}
+
+// Test: Reads beyond the ring's capacity go to the overflow reader, and the
+// destructor waits for every completion
+TEST_F(FileReaderTest, IoUringOverflowsWhenFull) {
+    std::shared_ptr<FileReader> threaded = FileReader::create_threaded(std::make_shared<BlockingExecutor>(2));
+    std::shared_ptr<FileReader> reader = FileReader::create_io_uring(2, threaded);
+    if (!reader) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+
+    std::atomic<int> completed{0};
+    std::vector<std::vector<char>> buffers(64, std::vector<char>(10));
+    for (auto& buffer : buffers) {
+        ASSERT_TRUE(reader->read(fd_, 0, buffer.data(), buffer.size(), [&completed](ssize_t n) {
+            if (n == 10) {
+                ++completed;
+            }
+        }));
+    }
+    reader.reset();
+    threaded.reset();
+    EXPECT_EQ(completed.load(), 64);
+    EXPECT_EQ(std::string(buffers.back().data(), 10), "0123456789");
+}
+
+// Test: create() prefers io_uring and otherwise falls back to threads
+TEST_F(FileReaderTest, CreatePicksABackend) {
+    std::shared_ptr<FileReader> reader = FileReader::create(std::make_shared<BlockingExecutor>(1));
+    ASSERT_NE(reader, nullptr);
+    std::string backend = reader->backend();
+    EXPECT_TRUE(backend == "io_uring" || backend == "threads");
+    check_reads(*reader);
+}
@@ -2,6 +2,7 @@
 #include "handler_factory.h"
 #include "echo_handler.h"
 #include "file_handler.h"
+#include "http_request.h"
 #include "server_config.h" // For HandlerConfig
 #include <memory>
 #include <string>
@@ -115,3 +116,90 @@ TEST_F(HandlerFactoryTest, ParseExtensionsWithExtraWhitespaceAndCommas) {
     
     EXPECT_EQ(result, expected);
 }
+
+// Test that handlers report their own blocking default
+TEST_F(HandlerFactoryTest, BlockingDefaults) {
+    HandlerConfig echo_config;
+    echo_config.type = "EchoHandler";
+    EXPECT_FALSE(factory.create_handler(echo_config, "/echo")->is_blocking());
+
+    HandlerConfig sleep_config;
+    sleep_config.type = "SleepHandler";
+    EXPECT_TRUE(factory.create_handler(sleep_config, "/sleep")->is_blocking());
+
+    HandlerConfig file_config;
+    file_config.type = "StaticHandler";
+    file_config.settings["root"] = test_dir_;
+    EXPECT_TRUE(factory.create_handler(file_config, "/static")->is_blocking());
+}
+
+// Test that "blocking on|off" in a location overrides the default
+TEST_F(HandlerFactoryTest, BlockingOverrideFromConfig) {
+    HandlerConfig echo_config;
+    echo_config.type = "EchoHandler";
+    echo_config.settings["blocking"] = "on";
+    EXPECT_TRUE(factory.create_handler(echo_config, "/echo")->is_blocking());
+
+    HandlerConfig sleep_config;
+    sleep_config.type = "SleepHandler";
+    sleep_config.settings["blocking"] = "off";
+    EXPECT_FALSE(factory.create_handler(sleep_config, "/sleep")->is_blocking());
+}
+
+// Test: "cache_size", "mmap_threshold" and "stat_cache" turn on the static file caches
+TEST_F(HandlerFactoryTest, FileCacheFromConfig) {
+    HandlerConfig config;
+    config.type = "StaticHandler";
+    config.settings["root"] = test_dir_;
+
+    auto uncached = factory.create_handler(config, "/static");
+    EXPECT_EQ(dynamic_cast<FileHandler*>(uncached.get())->cache(), nullptr);
+
+    config.settings["cache_size"] = "1048576";
+    auto cached = factory.create_handler(config, "/static");
+    auto* file_handler = dynamic_cast<FileHandler*>(cached.get());
+    ASSERT_NE(file_handler->cache(), nullptr);
+    EXPECT_EQ(file_handler->cache()->max_bytes(), 1048576u);
+    EXPECT_EQ(file_handler->mappings(), nullptr);
+
+    config.settings["mmap_threshold"] = "65536";
+    auto mapped = factory.create_handler(config, "/static");
+    EXPECT_NE(dynamic_cast<FileHandler*>(mapped.get())->mappings(), nullptr);
+
+    config.settings["stat_cache"] = "1000";
+    config.settings["stat_cache_ttl"] = "250";
+    auto stat_cached = factory.create_handler(config, "/static");
+    StatCache* stat_cache = dynamic_cast<FileHandler*>(stat_cached.get())->stat_cache();
+    ASSERT_NE(stat_cache, nullptr);
+    EXPECT_EQ(stat_cache->max_entries(), 1000u);
+    EXPECT_EQ(stat_cache->ttl(), std::chrono::milliseconds(250));
+}
+
+// Test: A CrudHandler with a root keeps its entities on disk, in one store
+// that handlers built later for the same root share
+TEST_F(HandlerFactoryTest, CrudHandlerWithRootIsDurable) {
+    // Stores outlive the test, so every run needs a root of its own
+    static int run = 0;
+    std::string root = test_dir_ + "/crud" + std::to_string(run++);
+    HandlerConfig config;
+    config.type = "CrudHandler";
+    config.settings["root"] = root;
+
+    auto writer = factory.create_handler(config, "/api");
+    HttpRequest post;
+    post.set_method("POST");
+    post.set_path("/api/Shoes");
+    post.set_version("HTTP/1.1");
+    post.set_body("{\"size\": 42}");
+    ASSERT_EQ(writer->handle_request(post).get_status_code(), 201);
+    EXPECT_TRUE(fs::exists(root + "/segment-000001.log"));
+
+    auto reader = factory.create_handler(config, "/api");
+    HttpRequest get;
+    get.set_method("GET");
+    get.set_path("/api/Shoes/1");
+    get.set_version("HTTP/1.1");
+    HttpResponse response = reader->handle_request(get);
+    EXPECT_EQ(response.get_status_code(), 200);
+    EXPECT_EQ(response.get_message_body(), "{\"size\": 42}");
+}
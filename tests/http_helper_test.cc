@@ -63,3 +63,58 @@ TEST(HttpHelperTest, CheckMalformedRequestRandomText) {
     std::string garbage = "GARBAGE DATA RANDOM TEXT";
     EXPECT_EQ(check_malformed_request(garbage), MalformedType::NoHeaderTerminator);
 }
+
+TEST(HttpHelperTest, ReasonPhrase) {
+    EXPECT_EQ(reason_phrase(200), "OK");
+    EXPECT_EQ(reason_phrase(413), "Content Too Large");
+    EXPECT_EQ(reason_phrase(501), "Not Implemented");
+    EXPECT_EQ(reason_phrase(299), "Unknown");
+}
+
+TEST(HttpHelperTest, AcceptsEncoding) {
+    EXPECT_TRUE(accepts_encoding("gzip, deflate, br", "br"));
+    EXPECT_TRUE(accepts_encoding("GZIP;q=0.5", "gzip"));
+    EXPECT_FALSE(accepts_encoding("gzip;q=0, br", "gzip"));
+    EXPECT_FALSE(accepts_encoding("deflate", "gzip"));
+    EXPECT_FALSE(accepts_encoding("", "gzip"));
+    EXPECT_TRUE(accepts_encoding("*", "br"));
+    EXPECT_FALSE(accepts_encoding("*, br;q=0.000", "br"));
+    EXPECT_FALSE(accepts_encoding("gzip, *;q=0", "br"));
+}
+
+TEST(HttpHelperTest, HttpDateRoundTrip) {
+    EXPECT_EQ(http_date(784111777), "Sun, 06 Nov 1994 08:49:37 GMT");
+    EXPECT_EQ(parse_http_date("Sun, 06 Nov 1994 08:49:37 GMT"), std::optional<time_t>(784111777));
+    EXPECT_EQ(parse_http_date("Sunday, 06-Nov-94 08:49:37 GMT"), std::nullopt);
+    EXPECT_EQ(parse_http_date("Sun, 06 Foo 1994 08:49:37 GMT"), std::nullopt);
+    EXPECT_EQ(parse_http_date("garbage"), std::nullopt);
+}
+
+TEST(HttpHelperTest, EtagMatches) {
+    EXPECT_TRUE(etag_matches("\"abc\"", "\"abc\""));
+    EXPECT_TRUE(etag_matches("\"x\", W/\"abc\"", "\"abc\""));
+    EXPECT_TRUE(etag_matches("*", "\"abc\""));
+    EXPECT_FALSE(etag_matches("\"abcd\"", "\"abc\""));
+    EXPECT_FALSE(etag_matches("", "\"abc\""));
+}
+
+TEST(HttpHelperTest, ParsesByteRanges) {
+    auto ranges = parse_byte_ranges("bytes=0-99, 200-, -50", 1000);
+    ASSERT_TRUE(ranges);
+    ASSERT_EQ(ranges->size(), 3u);
+    EXPECT_EQ((*ranges)[0].offset, 0u);
+    EXPECT_EQ((*ranges)[0].length, 100u);
+    EXPECT_EQ((*ranges)[1].offset, 200u);
+    EXPECT_EQ((*ranges)[1].length, 800u);
+    EXPECT_EQ((*ranges)[2].offset, 950u);
+    EXPECT_EQ((*ranges)[2].length, 50u);
+
+    auto clamped = parse_byte_ranges("bytes=990-2000", 1000);
+    ASSERT_TRUE(clamped);
+    EXPECT_EQ((*clamped)[0].length, 10u);
+
+    EXPECT_TRUE(parse_byte_ranges("bytes=1000-", 1000)->empty());
+    EXPECT_FALSE(parse_byte_ranges("items=0-1", 1000));
+    EXPECT_FALSE(parse_byte_ranges("bytes=5-1", 1000));
+    EXPECT_FALSE(parse_byte_ranges("bytes=a-b", 1000));
+}
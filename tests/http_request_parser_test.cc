@@ -0,0 +1,263 @@
+#include "http_request_parser.h"
+#include <gtest/gtest.h>
+#include <string>
+
+class HttpRequestParserTest : public ::testing::Test {
+protected:
+    HttpRequestParser parser_;
+};
+
+// Test a complete request in a single chunk
+TEST_F(HttpRequestParserTest, ParsesCompleteRequest) {
+    std::string raw =
+        "GET /index.html HTTP/1.1\r\n"
+        "Host: localhost\r\n"
+        "\r\n";
+
+    EXPECT_EQ(parser_.feed(raw), HttpRequestParser::Result::Complete);
+    EXPECT_EQ(parser_.method(), "GET");
+    EXPECT_EQ(parser_.target(), "/index.html");
+    EXPECT_EQ(parser_.version(), "HTTP/1.1");
+
+    HttpRequest request = parser_.take_request();
+    EXPECT_TRUE(request.is_valid());
+    EXPECT_EQ(request.get_header("Host").value(), "localhost");
+    EXPECT_EQ(request.raw_request(), raw);
+}
+
+// Test feeding the request one byte at a time
+TEST_F(HttpRequestParserTest, ResumesAcrossSingleByteChunks) {
+    std::string raw =
+        "POST /api/Shoes HTTP/1.1\r\n"
+        "Content-Type: application/json\r\n"
+        "Content-Length: 13\r\n"
+        "\r\n"
+        "{\"size\": 10}\n";
+
+    for (size_t i = 0; i + 1 < raw.size(); ++i) {
+        ASSERT_EQ(parser_.feed(raw.data() + i, 1), HttpRequestParser::Result::NeedMore) << i;
+    }
+    EXPECT_EQ(parser_.feed(raw.data() + raw.size() - 1, 1), HttpRequestParser::Result::Complete);
+
+    HttpRequest request = parser_.take_request();
+    EXPECT_EQ(request.method(), "POST");
+    EXPECT_EQ(request.path(), "/api/Shoes");
+    EXPECT_EQ(request.body(), "{\"size\": 10}\n");
+}
+
+// Test that the body is delimited by Content-Length
+TEST_F(HttpRequestParserTest, WaitsForContentLengthBody) {
+    EXPECT_EQ(parser_.feed("PUT /x HTTP/1.1\r\nContent-Length: 10\r\n\r\nhello"),
+              HttpRequestParser::Result::NeedMore);
+    EXPECT_EQ(parser_.state(), HttpRequestParser::State::Body);
+    EXPECT_EQ(parser_.body_received(), 5u);
+    EXPECT_EQ(parser_.content_length(), 10u);
+
+    EXPECT_EQ(parser_.feed("world"), HttpRequestParser::Result::Complete);
+    EXPECT_EQ(parser_.take_request().body(), "helloworld");
+}
+
+// Test that bytes past the end of a request are kept for the next one
+TEST_F(HttpRequestParserTest, KeepsBytesOfFollowingRequest) {
+    EXPECT_EQ(parser_.feed("GET /a HTTP/1.1\r\n\r\nGET /b HTTP/1.1\r\n"),
+              HttpRequestParser::Result::Complete);
+
+    HttpRequest first = parser_.take_request();
+    EXPECT_EQ(first.path(), "/a");
+    EXPECT_EQ(first.raw_request(), "GET /a HTTP/1.1\r\n\r\n");
+
+    EXPECT_EQ(parser_.state(), HttpRequestParser::State::Headers);
+    EXPECT_EQ(parser_.feed("\r\n"), HttpRequestParser::Result::Complete);
+    EXPECT_EQ(parser_.take_request().path(), "/b");
+}
+
+// Test a run of pipelined requests, the last split across feeds
+TEST_F(HttpRequestParserTest, ParsesPipelinedRequestsInOneBuffer) {
+    EXPECT_EQ(parser_.feed("POST /a HTTP/1.1\r\nContent-Length: 3\r\n\r\nabc"
+                           "POST /b HTTP/1.1\r\nContent-Length: 2\r\n\r\nde"
+                           "POST /c HTTP/1.1\r\nHost: x\r\nContent-"),
+              HttpRequestParser::Result::Complete);
+
+    HttpRequest first = parser_.take_request();
+    EXPECT_EQ(first.raw_request(), "POST /a HTTP/1.1\r\nContent-Length: 3\r\n\r\nabc");
+    EXPECT_EQ(first.body(), "abc");
+
+    HttpRequest second = parser_.take_request();
+    EXPECT_EQ(second.path(), "/b");
+    EXPECT_EQ(second.body(), "de");
+    EXPECT_EQ(parser_.buffered_bytes(), std::string("POST /c HTTP/1.1\r\nHost: x\r\nContent-").size());
+
+    EXPECT_EQ(parser_.feed("Length: 4\r\n\r\nfg"), HttpRequestParser::Result::NeedMore);
+    EXPECT_EQ(parser_.method(), "POST");
+    EXPECT_EQ(parser_.target(), "/c");
+    EXPECT_EQ(parser_.feed("hi"), HttpRequestParser::Result::Complete);
+
+    HttpRequest third = parser_.take_request();
+    EXPECT_EQ(third.raw_request(), "POST /c HTTP/1.1\r\nHost: x\r\nContent-Length: 4\r\n\r\nfghi");
+    EXPECT_EQ(third.get_header("Host"), "x");
+    EXPECT_EQ(third.body(), "fghi");
+    EXPECT_EQ(parser_.buffered_bytes(), 0u);
+}
+
+// Test an invalid Content-Length value
+TEST_F(HttpRequestParserTest, RejectsInvalidContentLength) {
+    EXPECT_EQ(parser_.feed("POST /x HTTP/1.1\r\nContent-Length: abc\r\n\r\n"),
+              HttpRequestParser::Result::Error);
+    EXPECT_EQ(parser_.error(), HttpRequestParser::ErrorType::BadContentLength);
+    EXPECT_EQ(parser_.error_message(), "Invalid Content-Length header");
+}
+
+// Test that repeated Content-Length headers must agree
+TEST_F(HttpRequestParserTest, RejectsConflictingContentLength) {
+    EXPECT_EQ(parser_.feed("POST /x HTTP/1.1\r\nContent-Length: 5\r\nContent-Length: 50\r\n\r\n"),
+              HttpRequestParser::Result::Error);
+    EXPECT_EQ(parser_.error(), HttpRequestParser::ErrorType::BadContentLength);
+    EXPECT_EQ(parser_.error_status_code(), 400);
+
+    parser_.reset();
+    EXPECT_EQ(parser_.feed("POST /x HTTP/1.1\r\nContent-Length: 5\r\nContent-Length: 5\r\n\r\nhello"),
+              HttpRequestParser::Result::Complete);
+    EXPECT_EQ(parser_.take_request().body(), "hello");
+}
+
+// Test that Transfer-Encoding may only be sent once
+TEST_F(HttpRequestParserTest, RejectsRepeatedTransferEncoding) {
+    EXPECT_EQ(parser_.feed("POST /x HTTP/1.1\r\nTransfer-Encoding: chunked\r\n"
+                           "Transfer-Encoding: chunked\r\n\r\n"),
+              HttpRequestParser::Result::Error);
+    EXPECT_EQ(parser_.error(), HttpRequestParser::ErrorType::BadTransferEncoding);
+    EXPECT_EQ(parser_.error_status_code(), 400);
+}
+
+// Test that garbage is rejected before its line is complete
+TEST_F(HttpRequestParserTest, RejectsGarbageEarly) {
+    EXPECT_EQ(parser_.feed("GARBAGE DATA RANDOM TEXT"), HttpRequestParser::Result::Error);
+    EXPECT_EQ(parser_.error(), HttpRequestParser::ErrorType::BadRequestLine);
+}
+
+// Test a request line without a version
+TEST_F(HttpRequestParserTest, RejectsIncompleteRequestLine) {
+    EXPECT_EQ(parser_.feed("GET /test\r\n\r\n"), HttpRequestParser::Result::Error);
+}
+
+// Test the header size limit
+TEST_F(HttpRequestParserTest, RejectsOversizedHeaders) {
+    parser_.feed("GET / HTTP/1.1\r\n");
+    std::string header = "X-Filler: " + std::string(1024, 'a') + "\r\n";
+    HttpRequestParser::Result result = HttpRequestParser::Result::NeedMore;
+    for (int i = 0; i < 100 && result == HttpRequestParser::Result::NeedMore; ++i) {
+        result = parser_.feed(header);
+    }
+    EXPECT_EQ(result, HttpRequestParser::Result::Error);
+    EXPECT_EQ(parser_.error(), HttpRequestParser::ErrorType::HeaderTooLarge);
+}
+
+// Test that leading blank lines are skipped
+TEST_F(HttpRequestParserTest, SkipsLeadingBlankLines) {
+    EXPECT_EQ(parser_.feed("\r\nGET /health HTTP/1.1\r\n\r\n"),
+              HttpRequestParser::Result::Complete);
+    EXPECT_EQ(parser_.take_request().path(), "/health");
+}
+
+// Test that reset drops everything buffered
+TEST_F(HttpRequestParserTest, ResetClearsState) {
+    parser_.feed("GARBAGE DATA");
+    ASSERT_EQ(parser_.state(), HttpRequestParser::State::Error);
+
+    parser_.reset();
+    EXPECT_EQ(parser_.buffered_bytes(), 0u);
+    EXPECT_EQ(parser_.feed("GET / HTTP/1.1\r\n\r\n"), HttpRequestParser::Result::Complete);
+}
+
+// Test a chunked body split across arbitrary reads
+TEST_F(HttpRequestParserTest, DecodesChunkedBody) {
+    std::string raw =
+        "POST /api/Shoes HTTP/1.1\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "\r\n"
+        "5\r\nhello\r\n"
+        "7;ext=1\r\n, world\r\n"
+        "0\r\n"
+        "X-Trailer: ignored\r\n"
+        "\r\n";
+
+    for (size_t i = 0; i + 1 < raw.size(); ++i) {
+        ASSERT_EQ(parser_.feed(raw.data() + i, 1), HttpRequestParser::Result::NeedMore) << i;
+    }
+    EXPECT_EQ(parser_.feed(raw.data() + raw.size() - 1, 1), HttpRequestParser::Result::Complete);
+    EXPECT_TRUE(parser_.is_chunked());
+
+    HttpRequest request = parser_.take_request();
+    EXPECT_EQ(request.body(), "hello, world");
+    EXPECT_EQ(request.get_header("Transfer-Encoding").value(), "chunked");
+}
+
+// Test that decoded data can be drained as it arrives and framing is not kept
+TEST_F(HttpRequestParserTest, StreamsChunkedBody) {
+    parser_.feed("PUT /upload HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n");
+    size_t head_size = parser_.buffered_bytes();
+
+    EXPECT_EQ(parser_.feed("a\r\n0123456789\r\n"), HttpRequestParser::Result::NeedMore);
+    EXPECT_EQ(parser_.take_body_data(), "0123456789");
+    EXPECT_EQ(parser_.buffered_bytes(), head_size);
+
+    EXPECT_EQ(parser_.feed("3\r\nabc"), HttpRequestParser::Result::NeedMore);
+    EXPECT_EQ(parser_.take_body_data(), "abc");
+    EXPECT_EQ(parser_.body_received(), 13u);
+
+    EXPECT_EQ(parser_.feed("\r\n0\r\n\r\nGET /next HTTP/1.1\r\n\r\n"), HttpRequestParser::Result::Complete);
+    EXPECT_EQ(parser_.take_request().body(), "");
+    EXPECT_EQ(parser_.state(), HttpRequestParser::State::Complete);
+    EXPECT_EQ(parser_.take_request().path(), "/next");
+}
+
+// Test malformed chunk framing
+TEST_F(HttpRequestParserTest, RejectsBadChunk) {
+    EXPECT_EQ(parser_.feed("POST /x HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n"),
+              HttpRequestParser::Result::Error);
+    EXPECT_EQ(parser_.error(), HttpRequestParser::ErrorType::BadChunk);
+
+    parser_.reset();
+    EXPECT_EQ(parser_.feed("POST /x HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabcX"),
+              HttpRequestParser::Result::Error);
+    EXPECT_EQ(parser_.error(), HttpRequestParser::ErrorType::BadChunk);
+}
+
+// Test Transfer-Encoding values the parser refuses
+TEST_F(HttpRequestParserTest, RejectsUnsupportedTransferEncoding) {
+    EXPECT_EQ(parser_.feed("POST /x HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n"),
+              HttpRequestParser::Result::Error);
+    EXPECT_EQ(parser_.error_status_code(), 501);
+
+    parser_.reset();
+    EXPECT_EQ(parser_.feed("POST /x HTTP/1.1\r\nTransfer-Encoding: chunked\r\nContent-Length: 3\r\n\r\n"),
+              HttpRequestParser::Result::Error);
+    EXPECT_EQ(parser_.error(), HttpRequestParser::ErrorType::BadTransferEncoding);
+}
+
+// Test the body size limit for both framings
+TEST_F(HttpRequestParserTest, EnforcesBodyLimit) {
+    parser_.set_max_body_bytes(8);
+    EXPECT_EQ(parser_.feed("POST /x HTTP/1.1\r\nContent-Length: 9\r\n\r\n"),
+              HttpRequestParser::Result::Error);
+    EXPECT_EQ(parser_.error_status_code(), 413);
+
+    parser_.reset();
+    parser_.feed("POST /x HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n");
+    EXPECT_EQ(parser_.feed("5\r\nabcde\r\n"), HttpRequestParser::Result::NeedMore);
+    EXPECT_EQ(parser_.feed("5\r\nfghij\r\n"), HttpRequestParser::Result::Error);
+    EXPECT_EQ(parser_.error(), HttpRequestParser::ErrorType::BodyTooLarge);
+}
+
+// Test that draining a chunked body does not reset its limit
+TEST_F(HttpRequestParserTest, EnforcesBodyLimitWhileDraining) {
+    parser_.set_max_body_bytes(8);
+    parser_.feed("POST /x HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n");
+    EXPECT_EQ(parser_.feed("5\r\nabcde\r\n"), HttpRequestParser::Result::NeedMore);
+    EXPECT_EQ(parser_.take_body_data(), "abcde");
+    EXPECT_EQ(parser_.feed("3\r\nfgh\r\n"), HttpRequestParser::Result::NeedMore);
+    EXPECT_EQ(parser_.take_body_data(), "fgh");
+    EXPECT_EQ(parser_.feed("1\r\ni\r\n"), HttpRequestParser::Result::Error);
+    EXPECT_EQ(parser_.error(), HttpRequestParser::ErrorType::BodyTooLarge);
+    EXPECT_EQ(parser_.error_status_code(), 413);
+}
@@ -171,4 +171,81 @@ TEST_F(HttpResponseTest, MultipleHeadersConstructor) {
     EXPECT_EQ(response.get_header("Cache-Control"), "no-cache");
     EXPECT_EQ(response.get_header("Server"), "MyServer/1.0");
     EXPECT_EQ(response.get_header("Content-Length"), "15");
-}
\ No newline at end of file
+}
+
+TEST_F(HttpResponseTest, SerializeHeadEndsBeforeBody) {
+    HttpResponse response("HTTP/1.1", 200, "OK", {{"Content-Type", "text/plain"}}, "Hello");
+
+    EXPECT_EQ(response.serialize_head(),
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Length: 5\r\n"
+        "Content-Type: text/plain\r\n"
+        "\r\n");
+    EXPECT_EQ(response.serialize_head() + response.get_message_body(), response.convert_to_string());
+}
+
+TEST_F(HttpResponseTest, ToBuffersReferencesBodyWithoutCopy) {
+    HttpResponse response("HTTP/1.1", 200, "OK", {}, std::string(100000, 'x'));
+    std::string head = response.serialize_head();
+
+    std::vector<boost::asio::const_buffer> buffers = response.to_buffers(head);
+    ASSERT_EQ(buffers.size(), 2u);
+    EXPECT_EQ(buffers[0].data(), head.data());
+    EXPECT_EQ(buffers[1].data(), response.get_message_body().data());
+    EXPECT_EQ(boost::asio::buffer_size(buffers), head.size() + 100000);
+}
+
+TEST_F(HttpResponseTest, ToBuffersSkipsEmptyBody) {
+    HttpResponse response("HTTP/1.1", 204, "No Content", {}, "");
+    std::string head = response.serialize_head();
+
+    EXPECT_EQ(response.to_buffers(head).size(), 1u);
+}
+
+TEST_F(HttpResponseTest, BodyStreamOfKnownSizeSetsContentLength) {
+    HttpResponse response("HTTP/1.1", 200, "OK", {}, "replaced");
+    response.set_body_stream(std::make_shared<GeneratorBody>([]() { return std::nullopt; }));
+    EXPECT_EQ(response.get_header("Transfer-Encoding"), "chunked");
+    EXPECT_EQ(response.get_header("Content-Length"), "");
+    EXPECT_EQ(response.get_message_body(), "");
+
+    response.set_message_body("plain");
+    EXPECT_EQ(response.get_body_stream(), nullptr);
+    EXPECT_EQ(response.get_header("Transfer-Encoding"), "");
+    EXPECT_EQ(response.get_header("Content-Length"), "5");
+}
+
+TEST_F(HttpResponseTest, PreparedResponseIsWrittenAsIs) {
+    auto head = std::make_shared<const std::string>(
+        "HTTP/1.1 200 OK\r\nContent-Length: 5\r\nContent-Type: text/plain\r\n\r\n");
+    auto body = std::make_shared<const std::string>("hello");
+    HttpResponse response;
+    response.set_prepared(200, head, body);
+
+    EXPECT_TRUE(response.is_prepared());
+    EXPECT_EQ(response.get_status_code(), 200);
+    EXPECT_EQ(response.get_reason_phrase(), "OK");
+    EXPECT_EQ(response.get_header("Content-Type"), "text/plain");
+    EXPECT_EQ(response.get_header("ETag"), "");
+    EXPECT_EQ(response.get_message_body(), "hello");
+    EXPECT_EQ(response.convert_to_string(), *head + "hello");
+
+    std::vector<boost::asio::const_buffer> buffers = response.to_buffers("");
+    ASSERT_EQ(buffers.size(), 2u);
+    EXPECT_EQ(buffers[0].data(), head->data());
+    EXPECT_EQ(buffers[1].data(), body->data());
+}
+
+TEST_F(HttpResponseTest, SettersUnpackPreparedResponse) {
+    HttpResponse response;
+    response.set_prepared(200,
+        std::make_shared<const std::string>("HTTP/1.1 200 OK\r\nContent-Length: 5\r\nContent-Type: text/plain\r\n\r\n"),
+        std::make_shared<const std::string>("hello"));
+
+    response.set_header("X-Extra", "1");
+    EXPECT_FALSE(response.is_prepared());
+    EXPECT_EQ(response.get_version(), "HTTP/1.1");
+    EXPECT_EQ(response.get_message_body(), "hello");
+    EXPECT_EQ(response.convert_to_string(),
+              "HTTP/1.1 200 OK\r\nContent-Length: 5\r\nContent-Type: text/plain\r\nX-Extra: 1\r\n\r\nhello");
+}
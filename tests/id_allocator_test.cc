@@ -0,0 +1,96 @@
+#include "gtest/gtest.h"
+#include "id_allocator.h"
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Test: Only canonical positive decimal IDs that fit in an int count
+TEST(IdAllocatorTest, ParsesCanonicalIds) {
+    EXPECT_EQ(IdAllocator::parse("1"), 1u);
+    EXPECT_EQ(IdAllocator::parse("2147483647"), 2147483647u);
+    EXPECT_FALSE(IdAllocator::parse("2147483648"));
+    EXPECT_FALSE(IdAllocator::parse("0"));
+    EXPECT_FALSE(IdAllocator::parse("07"));
+    EXPECT_FALSE(IdAllocator::parse("-1"));
+    EXPECT_FALSE(IdAllocator::parse("12abc"));
+    EXPECT_FALSE(IdAllocator::parse(""));
+}
+
+// Test: Without reuse IDs only go up, past every claimed one
+TEST(IdAllocatorTest, CountsUpWithoutReuse) {
+    IdAllocator ids(false);
+    EXPECT_EQ(ids.allocate(), "1");
+    ids.claim("10");
+    ids.claim("3");
+    ids.claim("name");
+    EXPECT_EQ(ids.allocate(), "11");
+    ids.release("11");
+    ids.release("10");
+    EXPECT_EQ(ids.allocate(), "12");
+}
+
+// Test: With reuse the smallest free ID comes first, whether it was
+// released or skipped over by a claim
+TEST(IdAllocatorTest, ReusesSmallestFreeId) {
+    IdAllocator ids(true);
+    ids.claim("1");
+    ids.claim("2");
+    ids.claim("4");
+    ids.claim("10");
+    EXPECT_EQ(ids.allocate(), "3");
+    ids.claim("6");
+    EXPECT_EQ(ids.allocate(), "5");
+    EXPECT_EQ(ids.allocate(), "7");
+
+    ids.release("2");
+    ids.release("1");
+    ids.release("1");
+    ids.release("99");
+    EXPECT_EQ(ids.allocate(), "1");
+    EXPECT_EQ(ids.allocate(), "2");
+    EXPECT_EQ(ids.allocate(), "8");
+    EXPECT_EQ(ids.allocate(), "9");
+    EXPECT_EQ(ids.allocate(), "11");
+}
+
+// Test: Running out of int-sized IDs is an error, not a wrap-around
+TEST(IdAllocatorTest, ThrowsWhenExhausted) {
+    IdAllocator ids(false);
+    ids.claim("2147483647");
+    EXPECT_THROW(ids.allocate(), std::overflow_error);
+
+    IdAllocator reusing(true);
+    reusing.claim("2147483647");
+    EXPECT_EQ(reusing.allocate(), "1");
+}
+
+// Test: Concurrent callers never get the same ID, with or without reuse
+TEST(IdAllocatorTest, ConcurrentAllocationsAreUnique) {
+    for (bool reuse : {false, true}) {
+        IdAllocators allocators(reuse);
+        std::mutex mutex;
+        std::set<std::string> seen;
+        size_t total = 0;
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 8; ++t) {
+            threads.emplace_back([&]() {
+                std::vector<std::string> mine;
+                for (int i = 0; i < 1000; ++i) {
+                    mine.push_back(allocators.get("Shoes").allocate());
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                seen.insert(mine.begin(), mine.end());
+                total += mine.size();
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        EXPECT_EQ(seen.size(), total);
+        EXPECT_EQ(allocators.get("Books").allocate(), "1");
+    }
+}
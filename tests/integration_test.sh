@@ -490,6 +490,74 @@ else
     exit 1
 fi
 
+# --- Test 13: Pipelined Requests ---
+echo ""
+echo "========== Test 13: Pipelined Requests =========="
+
+echo "Sending two requests back to back on one connection..."
+printf "GET /health HTTP/1.1\r\nHost: localhost\r\n\r\nGET /static/index.html HTTP/1.1\r\nHost: localhost\r\n\r\n" | nc -C localhost 80 -q 1 > ./tmp13.txt
+
+echo "Checking responses..."
+RESPONSE_COUNT=$(grep -c "200 OK" ./tmp13.txt || true)
+if [[ $RESPONSE_COUNT -eq 2 ]] && grep -q "Hello, World!" ./tmp13.txt; then
+    rm ./tmp13.txt
+    echo "Test 13 passed."
+else
+    echo "Test 13 failed - expected two responses in order"
+    echo "Actual output:"
+    cat ./tmp13.txt
+    exit 1
+fi
+
+# --- Test 14: Chunked Request Body ---
+echo ""
+echo "========== Test 14: Chunked Request Body =========="
+
+echo "Creating entity with a chunked POST body..."
+curl -s -i -X POST "localhost:80/api/Chunked" \
+     -H "Content-Type: application/json" \
+     -H "Transfer-Encoding: chunked" \
+     -d '{"name":"ChunkedProduct","price":1.25}' > ./tmp14_post.txt
+CHUNKED_ID=$(tail -n 1 ./tmp14_post.txt | sed -E 's/.*"id":[[:space:]]*([0-9]+).*/\1/')
+curl -s -i "localhost:80/api/Chunked/${CHUNKED_ID}" > ./tmp14_get.txt
+
+echo "Creating entity with a body split over several chunks..."
+printf 'POST /api/Chunked HTTP/1.1\r\nHost: localhost\r\nTransfer-Encoding: chunked\r\n\r\n8\r\n{"name":\r\n12\r\n"MultiChunkProduct\r\n2\r\n"}\r\n0\r\n\r\n' \
+    | nc localhost 80 -q 1 > ./tmp14_multi.txt
+MULTI_ID=$(tail -n 1 ./tmp14_multi.txt | sed -E 's/.*"id":[[:space:]]*([0-9]+).*/\1/')
+curl -s -i "localhost:80/api/Chunked/${MULTI_ID}" >> ./tmp14_get.txt
+
+echo "Checking responses..."
+if grep -q "201 Created" ./tmp14_post.txt && grep -q "201 Created" ./tmp14_multi.txt && \
+   grep -q "ChunkedProduct" ./tmp14_get.txt && grep -q '{"name":"MultiChunkProduct"}' ./tmp14_get.txt; then
+    rm ./tmp14_post.txt ./tmp14_multi.txt ./tmp14_get.txt
+    echo "Test 14 passed."
+else
+    echo "Test 14 failed - chunked body was not stored"
+    echo "Actual output:"
+    cat ./tmp14_post.txt ./tmp14_multi.txt ./tmp14_get.txt
+    exit 1
+fi
+
+echo ""
+echo "========== Test 15: No Requests After An Error Response =========="
+
+echo "Sending an oversized request followed by another request..."
+printf 'POST /echo HTTP/1.1\r\nHost: localhost\r\nContent-Length: 20000000\r\n\r\nGET /echo HTTP/1.1\r\nHost: localhost\r\n\r\n' \
+    | nc localhost 80 -q 1 > ./tmp15.txt
+
+echo "Checking response..."
+if grep -q "413 Content Too Large" ./tmp15.txt && grep -q "Connection: close" ./tmp15.txt && \
+   [ "$(grep -c '^HTTP/1.1' ./tmp15.txt)" -eq 1 ]; then
+    rm ./tmp15.txt
+    echo "Test 15 passed."
+else
+    echo "Test 15 failed - bytes after the error response were answered"
+    echo "Actual output:"
+    cat ./tmp15.txt
+    exit 1
+fi
+
 # --- Cleanup: Remove temporary files ---
 echo ""
 echo "========== Cleanup =========="
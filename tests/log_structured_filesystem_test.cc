@@ -0,0 +1,211 @@
+#include "gtest/gtest.h"
+#include "log_structured_filesystem.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+class LogStructuredFilesystemTest : public testing::Test {
+protected:
+    void SetUp() override {
+        fs::remove_all(root_);
+        open();
+    }
+
+    void TearDown() override {
+        store_.reset();
+        fs::remove_all(root_);
+    }
+
+    // (Re)opens the store, as a restarted server would
+    void open(LogStructuredFilesystem::Options options = LogStructuredFilesystem::Options()) {
+        store_.reset();
+        store_ = std::make_unique<LogStructuredFilesystem>(root_, options);
+    }
+
+    std::string segment(int number) const {
+        char name[32];
+        snprintf(name, sizeof(name), "segment-%06d.log", number);
+        return root_ + "/" + name;
+    }
+
+    std::string root_ = "./log_structured_filesystem_test_data";
+    std::unique_ptr<LogStructuredFilesystem> store_;
+    Entity shoes_{"Shoes"};
+    Entity books_{"Books"};
+};
+
+// Test: The basic operations behave like the in-memory store
+TEST_F(LogStructuredFilesystemTest, ReadsWritesAndDeletes) {
+    EXPECT_FALSE(store_->entity_exists(shoes_, "1"));
+    EXPECT_THROW(store_->read_entity(shoes_, "1"), std::runtime_error);
+
+    EXPECT_TRUE(store_->write_entity(shoes_, "1", "{\"size\": 42}"));
+    EXPECT_TRUE(store_->write_entity(books_, "1", "{\"pages\": 300}"));
+    EXPECT_TRUE(store_->entity_exists(shoes_, "1"));
+    EXPECT_EQ(store_->read_entity(shoes_, "1"), "{\"size\": 42}");
+    EXPECT_EQ(store_->read_entity(books_, "1"), "{\"pages\": 300}");
+
+    EXPECT_TRUE(store_->write_entity(shoes_, "1", "{\"size\": 43}"));
+    EXPECT_EQ(store_->read_entity(shoes_, "1"), "{\"size\": 43}");
+
+    EXPECT_TRUE(store_->delete_entity(shoes_, "1"));
+    EXPECT_FALSE(store_->delete_entity(shoes_, "1"));
+    EXPECT_FALSE(store_->entity_exists(shoes_, "1"));
+    EXPECT_TRUE(store_->entity_exists(books_, "1"));
+    EXPECT_GT(store_->dead_bytes(), 0u);
+}
+
+// Test: Everything written is still there after a restart, deletes included
+TEST_F(LogStructuredFilesystemTest, SurvivesRestart) {
+    store_->write_entity(shoes_, "1", "one");
+    store_->write_entity(shoes_, "2", "two");
+    store_->write_entity(shoes_, "2", "two again");
+    store_->write_entity(shoes_, "3", "three");
+    store_->delete_entity(shoes_, "3");
+    store_->write_entity(books_, "1", "");
+
+    open();
+
+    std::vector<std::string> ids = store_->list_entity_ids(shoes_);
+    EXPECT_EQ(std::unordered_set<std::string>(ids.begin(), ids.end()),
+              (std::unordered_set<std::string>{"1", "2"}));
+    EXPECT_EQ(store_->read_entity(shoes_, "1"), "one");
+    EXPECT_EQ(store_->read_entity(shoes_, "2"), "two again");
+    EXPECT_TRUE(store_->entity_exists(books_, "1"));
+    EXPECT_EQ(store_->read_entity(books_, "1"), "");
+    // 3 was deleted, but is still not handed out again
+    EXPECT_EQ(store_->next_entity_id(shoes_), "4");
+}
+
+// Test: A record torn by a crash is cut off, and the store keeps working
+TEST_F(LogStructuredFilesystemTest, DropsTornRecord) {
+    store_->write_entity(shoes_, "1", "kept");
+    store_.reset();
+    uintmax_t intact = fs::file_size(segment(1));
+    {
+        std::ofstream file(segment(1), std::ios::binary | std::ios::app);
+        file << "\x7f\x00\x00";
+    }
+
+    open();
+    EXPECT_EQ(fs::file_size(segment(1)), intact);
+    EXPECT_EQ(store_->read_entity(shoes_, "1"), "kept");
+
+    EXPECT_TRUE(store_->write_entity(shoes_, "2", "after"));
+    open();
+    EXPECT_EQ(store_->read_entity(shoes_, "1"), "kept");
+    EXPECT_EQ(store_->read_entity(shoes_, "2"), "after");
+}
+
+// Test: A record whose checksum does not match is not replayed
+TEST_F(LogStructuredFilesystemTest, DropsCorruptRecord) {
+    store_->write_entity(shoes_, "1", "good");
+    store_->write_entity(shoes_, "2", "flipped");
+    store_.reset();
+    {
+        std::fstream file(segment(1), std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(-1, std::ios::end);
+        file.put('X');
+    }
+
+    open();
+    EXPECT_EQ(store_->read_entity(shoes_, "1"), "good");
+    EXPECT_FALSE(store_->entity_exists(shoes_, "2"));
+}
+
+// Test: Damage inside a sealed segment fails the open and destroys nothing
+TEST_F(LogStructuredFilesystemTest, CorruptSealedSegmentThrows) {
+    LogStructuredFilesystem::Options options;
+    options.segment_bytes = 64;
+    open(options);
+    for (int i = 1; i <= 10; ++i) {
+        ASSERT_TRUE(store_->write_entity(shoes_, std::to_string(i), "value " + std::to_string(i)));
+    }
+    ASSERT_TRUE(fs::exists(segment(2)));
+    store_.reset();
+
+    // The first record's value is its last byte, so this leaves the
+    // records after it intact
+    uintmax_t size = fs::file_size(segment(1));
+    {
+        std::fstream file(segment(1), std::ios::binary | std::ios::in | std::ios::out);
+        file.seekg(0);
+        // checksum, type, then the entity, id and value sizes
+        char header[17];
+        file.read(header, sizeof(header));
+        ASSERT_TRUE(file);
+        uint32_t sizes[3];
+        std::memcpy(sizes, header + 5, sizeof(sizes));
+        uint32_t record_size = sizeof(header) + sizes[0] + sizes[1] + sizes[2];
+        ASSERT_LT(record_size, size);
+        file.seekp(record_size - 1);
+        file.put('X');
+    }
+
+    EXPECT_THROW(open(options), std::runtime_error);
+    EXPECT_EQ(fs::file_size(segment(1)), size);
+}
+
+// Test: Writes roll over into new segments, and all of them are replayed
+TEST_F(LogStructuredFilesystemTest, RollsSegments) {
+    LogStructuredFilesystem::Options options;
+    options.segment_bytes = 64;
+    options.sync = true;
+    open(options);
+
+    for (int i = 1; i <= 10; ++i) {
+        ASSERT_TRUE(store_->write_entity(shoes_, std::to_string(i), "value " + std::to_string(i)));
+    }
+    EXPECT_GT(store_->segments(), 1u);
+    EXPECT_TRUE(fs::exists(segment(2)));
+
+    open(options);
+    for (int i = 1; i <= 10; ++i) {
+        EXPECT_EQ(store_->read_entity(shoes_, std::to_string(i)), "value " + std::to_string(i));
+    }
+}
+
+// Test: IDs only go up, across deletes and restarts
+TEST_F(LogStructuredFilesystemTest, NextEntityIdNeverRepeats) {
+    EXPECT_EQ(store_->next_entity_id(shoes_), "1");
+    EXPECT_EQ(store_->next_entity_id(shoes_), "2");
+    store_->write_entity(shoes_, "1", "a");
+    store_->write_entity(shoes_, "5", "e");
+    store_->write_entity(shoes_, "name", "x");
+    EXPECT_EQ(store_->next_entity_id(shoes_), "6");
+    EXPECT_EQ(store_->next_entity_id(books_), "1");
+
+    store_->delete_entity(shoes_, "5");
+    open();
+    EXPECT_EQ(store_->next_entity_id(shoes_), "6");
+}
+
+// Test: With reuse_ids, deleted and skipped IDs are handed out again,
+// smallest first, like the in-memory store does
+TEST_F(LogStructuredFilesystemTest, NextEntityIdReusesWhenAsked) {
+    LogStructuredFilesystem::Options options;
+    options.reuse_ids = true;
+    open(options);
+
+    store_->write_entity(shoes_, "1", "a");
+    store_->write_entity(shoes_, "2", "b");
+    store_->write_entity(shoes_, "4", "d");
+    store_->delete_entity(shoes_, "2");
+
+    open(options);
+    EXPECT_EQ(store_->next_entity_id(shoes_), "2");
+    EXPECT_EQ(store_->next_entity_id(shoes_), "3");
+    EXPECT_EQ(store_->next_entity_id(shoes_), "5");
+}
+
+// Test: A root that cannot be created is reported
+TEST_F(LogStructuredFilesystemTest, UnusableRootThrows) {
+    std::string file = root_ + "/not_a_directory";
+    std::ofstream(file) << "x";
+    EXPECT_THROW(LogStructuredFilesystem(file + "/data"), std::runtime_error);
+}
@@ -0,0 +1,98 @@
+#include "mapped_file.h"
+#include "response_body.h"
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+
+namespace fs = std::filesystem;
+
+class MappedFileTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        fs::create_directories(dir_);
+    }
+
+    void TearDown() override {
+        fs::remove_all(dir_);
+    }
+
+    std::string write_file(const std::string& name, const std::string& content) {
+        std::string path = dir_ + "/" + name;
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << content;
+        return path;
+    }
+
+    // acquire() as FileHandler calls it, with a fresh stat
+    std::shared_ptr<const MappedFile> acquire(MappingCache& cache, const std::string& path) {
+        struct stat file_stat;
+        EXPECT_EQ(::stat(path.c_str(), &file_stat), 0);
+        int64_t mtime_ns = static_cast<int64_t>(file_stat.st_mtim.tv_sec) * 1000000000 + file_stat.st_mtim.tv_nsec;
+        return cache.acquire(path, file_stat.st_ino, file_stat.st_size, mtime_ns);
+    }
+
+    std::string dir_ = "./mapped_file_test_files";
+};
+
+// Test: A mapping exposes the file's bytes
+TEST_F(MappedFileTest, MapsFileContents) {
+    std::string path = write_file("a.txt", "hello mapped world");
+    std::shared_ptr<const MappedFile> mapped = MappedFile::map(path);
+
+    EXPECT_EQ(std::string(mapped->data(), mapped->size()), "hello mapped world");
+    EXPECT_EQ(MappedFile::map(write_file("empty.txt", ""))->size(), 0u);
+    EXPECT_THROW(MappedFile::map(dir_ + "/missing.txt"), std::runtime_error);
+}
+
+// Test: Concurrent users of an unchanged file share one mapping, which goes
+// away with its last user
+TEST_F(MappedFileTest, SharesMappingWhileInUse) {
+    MappingCache cache;
+    std::string path = write_file("a.txt", "shared");
+
+    std::shared_ptr<const MappedFile> first = acquire(cache, path);
+    std::shared_ptr<const MappedFile> second = acquire(cache, path);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(cache.mapped_files(), 1u);
+
+    first.reset();
+    second.reset();
+    EXPECT_EQ(cache.mapped_files(), 0u);
+}
+
+// Test: A file replaced on disk is mapped again, while the old mapping stays
+// readable for whoever still holds it
+TEST_F(MappedFileTest, RemapsChangedFile) {
+    MappingCache cache;
+    std::string path = write_file("a.txt", "old");
+    std::shared_ptr<const MappedFile> old_mapping = acquire(cache, path);
+
+    std::string replacement = write_file("a.txt.new", "new contents");
+    ASSERT_EQ(std::rename(replacement.c_str(), path.c_str()), 0);
+
+    std::shared_ptr<const MappedFile> new_mapping = acquire(cache, path);
+    EXPECT_NE(old_mapping, new_mapping);
+    EXPECT_EQ(std::string(new_mapping->data(), new_mapping->size()), "new contents");
+    EXPECT_EQ(std::string(old_mapping->data(), old_mapping->size()), "old");
+}
+
+// Test: A MappedBody hands out spans of its range without copying
+TEST_F(MappedFileTest, MappedBodyServesRange) {
+    std::shared_ptr<const MappedFile> mapped = MappedFile::map(write_file("digits.txt", "0123456789"));
+
+    MappedBody body(mapped, 2, 6);
+    EXPECT_EQ(body.size(), 6u);
+    std::string_view span = body.next_span(4);
+    EXPECT_EQ(span, "2345");
+    EXPECT_EQ(span.data(), mapped->data() + 2);
+
+    char buffer[8];
+    EXPECT_EQ(body.read(buffer, sizeof(buffer)), 2u);
+    EXPECT_EQ(std::string(buffer, 2), "67");
+    EXPECT_TRUE(body.next_span(4).empty());
+
+    EXPECT_THROW(MappedBody(mapped, 8, 3), std::runtime_error);
+}
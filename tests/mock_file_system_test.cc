@@ -1,8 +1,11 @@
 #include "gtest/gtest.h"
 #include "mock_filesystem.h"
 #include "filesystem_interface.h"
+#include <mutex>
+#include <thread>
 #include <unordered_set>
 #include <string>
+#include <vector>
 
 static Entity make_entity(const std::string& name) {
     Entity e;
@@ -151,4 +154,67 @@ TEST_F(MockFilesystemTest, ResetClearsAllData) {
     EXPECT_FALSE(fs_.entity_exists(e2_, "1"));
     EXPECT_TRUE(fs_.list_entity_ids(e1_).empty());
     EXPECT_TRUE(fs_.list_entity_ids(e2_).empty());
-}
\ No newline at end of file
+}
+
+TEST_F(MockFilesystemTest, ConcurrentWritersAndReadersKeepEveryEntity) {
+    constexpr int kThreads = 8;
+    constexpr int kPerThread = 500;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([this, t]() {
+            Entity& entity = t % 2 ? e1_ : e2_;
+            for (int i = 0; i < kPerThread; ++i) {
+                std::string id = std::to_string(t * kPerThread + i);
+                fs_.write_entity(entity, id, "value " + id);
+                EXPECT_EQ(fs_.read_entity(entity, id), "value " + id);
+                // Readers of other shards and listings run alongside
+                fs_.entity_exists(entity, std::to_string(i));
+                if (i % 100 == 0) {
+                    fs_.list_entity_ids(entity);
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(fs_.list_entity_ids(e1_).size() + fs_.list_entity_ids(e2_).size(),
+              static_cast<size_t>(kThreads * kPerThread));
+    for (int t = 0; t < kThreads; ++t) {
+        Entity& entity = t % 2 ? e1_ : e2_;
+        for (int i = 0; i < kPerThread; ++i) {
+            std::string id = std::to_string(t * kPerThread + i);
+            ASSERT_EQ(fs_.read_entity(entity, id), "value " + id);
+        }
+    }
+}
+
+TEST_F(MockFilesystemTest, ConcurrentPostsGetDistinctIds) {
+    std::mutex mutex;
+    std::unordered_set<std::string> seen;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < 200; ++i) {
+                std::string id = fs_.next_entity_id(e1_);
+                fs_.write_entity(e1_, id, "x");
+                std::lock_guard<std::mutex> lock(mutex);
+                EXPECT_TRUE(seen.insert(id).second) << id;
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(fs_.list_entity_ids(e1_).size(), 1600u);
+}
+
+TEST_F(MockFilesystemTest, NextEntityIdWithoutReuseSkipsDeletedIds) {
+    MockFilesystem fs(false);
+    fs.write_entity(e1_, "1", "a");
+    fs.write_entity(e1_, "2", "b");
+    fs.delete_entity(e1_, "2");
+    EXPECT_EQ(fs.next_entity_id(e1_), "3");
+}
@@ -345,3 +345,47 @@ TEST_F(PathRouterTest, DeepNestedPathReturnsNotFoundHandler) {
     EXPECT_EQ(response.get_message_body(), "<h1>404 Not Found</h1>");
 }
 
+
+// Test: Handlers are built once and shared between requests
+TEST_F(PathRouterTest, ReturnsSameHandlerInstance) {
+    HandlerConfig echo_config;
+    echo_config.type = "EchoHandler";
+    routes_["/echo"] = echo_config;
+
+    ServerConfig server_config = create_config_with_routes(routes_);
+    PathRouter router(server_config);
+
+    auto handler1 = router.match_handler("/echo");
+    auto handler2 = router.match_handler("/echo/other");
+    ASSERT_NE(handler1, nullptr);
+    EXPECT_EQ(handler1.get(), handler2.get());
+    EXPECT_EQ(router.match_handler("/a").get(), router.match_handler("/b").get());
+}
+
+// Test: A location whose handler fails validation falls back to NotFoundHandler
+TEST_F(PathRouterTest, InvalidRootFallsBackToNotFound) {
+    HandlerConfig file_config;
+    file_config.type = "StaticHandler";
+    file_config.settings["root"] = "/nonexistent/static/root";
+    routes_["/static"] = file_config;
+
+    ServerConfig server_config = create_config_with_routes(routes_);
+    PathRouter router(server_config);
+
+    auto handler = router.match_handler("/static/index.html");
+    ASSERT_NE(handler, nullptr);
+    EXPECT_EQ(handler->get_handler_name(), "NotFoundHandler");
+}
+
+// Test: A location does not match paths that merely share its prefix
+TEST_F(PathRouterTest, MatchesWholeSegmentsOnly) {
+    HandlerConfig echo_config;
+    echo_config.type = "EchoHandler";
+    routes_["/api"] = echo_config;
+
+    ServerConfig server_config = create_config_with_routes(routes_);
+    PathRouter router(server_config);
+
+    EXPECT_EQ(router.match_handler("/api?q=1")->get_handler_name(), "EchoHandler");
+    EXPECT_EQ(router.match_handler("/apiary")->get_handler_name(), "NotFoundHandler");
+}
@@ -0,0 +1,120 @@
+#include "response_body.h"
+#include "gtest/gtest.h"
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+class ResponseBodyTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::ofstream file(path_, std::ios::binary);
+        file << "0123456789abcdef";
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(path_);
+    }
+
+    static std::string drain(ResponseBody& body, size_t piece) {
+        std::string result;
+        std::vector<char> buffer(piece);
+        while (size_t n = body.read(buffer.data(), buffer.size())) {
+            result.append(buffer.data(), n);
+        }
+        return result;
+    }
+
+    std::string path_ = "./response_body_test_file.txt";
+};
+
+// Test: A file body serves exactly its byte range
+TEST_F(ResponseBodyTest, FileBodyReadsRange) {
+    FileBody body(path_, 4, 8);
+    EXPECT_EQ(body.size().value(), 8u);
+    EXPECT_EQ(drain(body, 3), "456789ab");
+}
+
+// Test: A missing file is reported when the body is created
+TEST_F(ResponseBodyTest, FileBodyMissingFileThrows) {
+    EXPECT_THROW(FileBody("./no_such_file", 0, 1), std::runtime_error);
+}
+
+// Test: A body made from an open descriptor owns it, and a failed open()
+// or dup() passed straight in is reported
+TEST_F(ResponseBodyTest, FileBodyAdoptsDescriptor) {
+    int fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    ASSERT_GE(fd, 0);
+    {
+        FileBody body(fd, 10, 6);
+        EXPECT_EQ(drain(body, 4), "abcdef");
+    }
+    EXPECT_EQ(::fcntl(fd, F_GETFD), -1);
+    EXPECT_THROW(FileBody(-1, 0, 1), std::runtime_error);
+}
+
+// Test: A file that is shorter than promised fails instead of ending early
+TEST_F(ResponseBodyTest, FileBodyShortFileThrows) {
+    FileBody body(path_, 10, 20);
+    char buffer[64];
+    EXPECT_EQ(body.read(buffer, sizeof(buffer)), 6u);
+    EXPECT_THROW(body.read(buffer, sizeof(buffer)), std::runtime_error);
+}
+
+// Test: send_to copies the range straight into a socket
+TEST_F(ResponseBodyTest, FileBodySendsRangeToSocket) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+    FileBody body(path_, 2, 10);
+    bool would_block = true;
+    size_t total = 0;
+    while (size_t n = body.send_to(fds[0], 4, would_block)) {
+        EXPECT_LE(n, 4u);
+        total += n;
+    }
+    EXPECT_FALSE(would_block);
+    EXPECT_EQ(total, 10u);
+    EXPECT_EQ(body.remaining(), 0u);
+
+    char received[16] = {};
+    EXPECT_EQ(::read(fds[1], received, sizeof(received)), 10);
+    EXPECT_EQ(std::string(received, 10), "23456789ab");
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+// Test: Generator pieces are split to fit and empty pieces are skipped
+TEST_F(ResponseBodyTest, GeneratorBodyConcatenatesPieces) {
+    std::vector<std::string> pieces = {"hello", "", ", ", "world"};
+    size_t next = 0;
+    GeneratorBody body([&]() -> std::optional<std::string> {
+        if (next == pieces.size()) {
+            return std::nullopt;
+        }
+        return pieces[next++];
+    });
+
+    EXPECT_FALSE(body.size().has_value());
+    EXPECT_EQ(drain(body, 4), "hello, world");
+}
+
+// Test: A composite body sends its parts in order and sums their sizes
+TEST_F(ResponseBodyTest, CompositeBodyConcatenatesParts) {
+    CompositeBody body;
+    body.append(std::make_shared<StringBody>("<"));
+    body.append(std::make_shared<FileBody>(path_, 2, 3));
+    body.append(std::make_shared<StringBody>(""));
+    body.append(std::make_shared<FileBody>(path_, 14, 2));
+    body.append(std::make_shared<StringBody>(">"));
+
+    EXPECT_EQ(body.size().value(), 7u);
+    EXPECT_EQ(drain(body, 2), "<234ef>");
+
+    CompositeBody unknown;
+    unknown.append(std::make_shared<GeneratorBody>([]() { return std::nullopt; }));
+    EXPECT_FALSE(unknown.size().has_value());
+}
@@ -0,0 +1,77 @@
+#include "route_trie.h"
+#include "echo_handler.h"
+#include "gtest/gtest.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+class RouteTrieTest : public ::testing::Test {
+protected:
+    std::shared_ptr<RequestHandler> add(const std::string& prefix) {
+        auto handler = std::make_shared<EchoHandler>();
+        trie_.insert(prefix, handler);
+        return handler;
+    }
+
+    RouteTrie trie_;
+};
+
+// Test: The longest matching location wins
+TEST_F(RouteTrieTest, MatchesLongestPrefix) {
+    auto api = add("/api");
+    auto files = add("/api/files");
+    auto root = add("/");
+
+    EXPECT_EQ(trie_.match("/api"), api);
+    EXPECT_EQ(trie_.match("/api/users/1"), api);
+    EXPECT_EQ(trie_.match("/api/files/a.txt"), files);
+    EXPECT_EQ(trie_.match("/other"), root);
+    EXPECT_EQ(trie_.size(), 3u);
+}
+
+// Test: Locations only match on path-segment boundaries
+TEST_F(RouteTrieTest, MatchesOnSegmentBoundaries) {
+    auto api = add("/api");
+
+    EXPECT_EQ(trie_.match("/api/"), api);
+    EXPECT_EQ(trie_.match("/apiary"), nullptr);
+    EXPECT_EQ(trie_.match("/ap"), nullptr);
+
+    auto root = add("/");
+    EXPECT_EQ(trie_.match("/apiary"), root);
+}
+
+// Test: The query string and fragment are not part of the matched path
+TEST_F(RouteTrieTest, IgnoresQueryString) {
+    auto echo = add("/echo");
+
+    EXPECT_EQ(trie_.match("/echo?x=/y"), echo);
+    EXPECT_EQ(trie_.match("/echo#top"), echo);
+    EXPECT_EQ(trie_.match("/echoes?x=1"), nullptr);
+}
+
+// Test: Trailing slashes on locations are ignored and re-inserting replaces
+TEST_F(RouteTrieTest, NormalizesTrailingSlash) {
+    add("/static/");
+    auto replaced = add("/static");
+
+    EXPECT_EQ(trie_.match("/static"), replaced);
+    EXPECT_EQ(trie_.match("/static/a.css"), replaced);
+    EXPECT_EQ(trie_.size(), 1u);
+}
+
+// Test: Splitting edges keeps every existing location reachable
+TEST_F(RouteTrieTest, SplitsSharedPrefixes) {
+    std::vector<std::string> prefixes = {"/archive", "/api", "/a", "/app/v2", "/app", "/b"};
+    std::vector<std::shared_ptr<RequestHandler>> handlers;
+    for (const std::string& prefix : prefixes) {
+        handlers.push_back(add(prefix));
+    }
+
+    for (size_t i = 0; i < prefixes.size(); ++i) {
+        EXPECT_EQ(trie_.match(prefixes[i]), handlers[i]) << prefixes[i];
+        EXPECT_EQ(trie_.match(prefixes[i] + "/x"), handlers[i]) << prefixes[i];
+    }
+    EXPECT_EQ(trie_.match("/app/v"), handlers[4]);
+    EXPECT_EQ(trie_.match("/c"), nullptr);
+}
@@ -0,0 +1,87 @@
+#include "router_handle.h"
+#include "config_parser.h"
+#include "server_config.h"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+class RouterHandleTest : public ::testing::Test {
+protected:
+    // Router with a single location of the given handler type at /app
+    std::shared_ptr<const PathRouter> make_router(const std::string& type) {
+        std::istringstream input("server { listen 8080; location /app { handler " + type + "; } }");
+        NginxConfigParser parser;
+        NginxConfig config;
+        ServerConfig server_config;
+        EXPECT_TRUE(parser.Parse(&input, &config));
+        EXPECT_TRUE(server_config.load_from_nginx_config(config));
+        return std::make_shared<PathRouter>(server_config);
+    }
+};
+
+// Test: current() returns the router passed at construction
+TEST_F(RouterHandleTest, ReturnsInitialRouter) {
+    auto router = make_router("EchoHandler");
+    RouterHandle handle(router);
+
+    EXPECT_EQ(handle.current(), router);
+    EXPECT_EQ(handle.current(), router);
+    EXPECT_EQ(handle.generation(), 0u);
+}
+
+// Test: publish() swaps the router while holders of the old one keep it
+TEST_F(RouterHandleTest, PublishSwapsRouter) {
+    RouterHandle handle(make_router("EchoHandler"));
+    std::shared_ptr<const PathRouter> old_router = handle.current();
+
+    handle.publish(make_router("HealthHandler"));
+    EXPECT_EQ(handle.generation(), 1u);
+    EXPECT_NE(handle.current(), old_router);
+    EXPECT_EQ(handle.current()->match_handler("/app")->get_handler_name(), "HealthHandler");
+    EXPECT_EQ(old_router->match_handler("/app")->get_handler_name(), "EchoHandler");
+}
+
+// Test: Handles do not share the per-thread cache
+TEST_F(RouterHandleTest, KeepsHandlesApart) {
+    auto first_router = make_router("EchoHandler");
+    auto second_router = make_router("HealthHandler");
+    RouterHandle first(first_router);
+    RouterHandle second(second_router);
+
+    EXPECT_EQ(first.current(), first_router);
+    EXPECT_EQ(second.current(), second_router);
+    EXPECT_EQ(first.current(), first_router);
+}
+
+// Test: Readers on other threads see a router published after they started
+TEST_F(RouterHandleTest, ReadersPickUpNewRouter) {
+    RouterHandle handle(make_router("EchoHandler"));
+    auto new_router = make_router("HealthHandler");
+    std::atomic<bool> published{false};
+    std::atomic<int> switched{0};
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&]() {
+            while (true) {
+                bool was_published = published.load();
+                if (handle.current() == new_router) {
+                    ++switched;
+                    return;
+                }
+                ASSERT_FALSE(was_published);
+            }
+        });
+    }
+
+    handle.publish(new_router);
+    published = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(switched.load(), 4);
+}
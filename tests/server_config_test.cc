@@ -222,3 +222,68 @@ TEST_F(ServerConfigTest, LocationMissingPath) {
     EXPECT_FALSE(success); // Fails because routes are empty
     EXPECT_TRUE(server_config_.get_routes().empty());
 }
+
+// Test the thread_mode directive
+TEST_F(ServerConfigTest, ThreadModePerCore) {
+    // server {
+    //   listen 8080;
+    //   thread_mode per_core;
+    //   location / { handler Echo; }
+    // }
+    auto server_block_stmt = CreateStatement({"server"});
+    server_block_stmt->child_block_ = std::make_unique<NginxConfig>();
+
+    server_block_stmt->child_block_->statements_.push_back(CreateStatement({"listen", "8080"}));
+    server_block_stmt->child_block_->statements_.push_back(CreateStatement({"thread_mode", "per_core"}));
+
+    auto location_stmt = CreateStatement({"location", "/"});
+    location_stmt->child_block_ = std::make_unique<NginxConfig>();
+    location_stmt->child_block_->statements_.push_back(CreateStatement({"handler", "Echo"}));
+    server_block_stmt->child_block_->statements_.push_back(location_stmt);
+
+    mock_config_.statements_.push_back(server_block_stmt);
+
+    EXPECT_EQ(server_config_.get_thread_mode(), ThreadMode::Shared); // Default
+    EXPECT_TRUE(server_config_.load_from_nginx_config(mock_config_));
+    EXPECT_EQ(server_config_.get_thread_mode(), ThreadMode::PerCore);
+}
+
+// Test the file_io directive
+TEST_F(ServerConfigTest, FileIoAsync) {
+    auto server_block_stmt = CreateStatement({"server"});
+    server_block_stmt->child_block_ = std::make_unique<NginxConfig>();
+
+    server_block_stmt->child_block_->statements_.push_back(CreateStatement({"listen", "8080"}));
+    server_block_stmt->child_block_->statements_.push_back(CreateStatement({"file_io", "async"}));
+
+    auto location_stmt = CreateStatement({"location", "/"});
+    location_stmt->child_block_ = std::make_unique<NginxConfig>();
+    location_stmt->child_block_->statements_.push_back(CreateStatement({"handler", "Echo"}));
+    server_block_stmt->child_block_->statements_.push_back(location_stmt);
+
+    mock_config_.statements_.push_back(server_block_stmt);
+
+    EXPECT_EQ(server_config_.get_file_io(), FileIo::Sendfile); // Default
+    EXPECT_TRUE(server_config_.load_from_nginx_config(mock_config_));
+    EXPECT_EQ(server_config_.get_file_io(), FileIo::Async);
+
+    server_block_stmt->child_block_->statements_[1] = CreateStatement({"file_io", "mmap"});
+    EXPECT_FALSE(server_config_.load_from_nginx_config(mock_config_));
+}
+
+// Test failure on an unknown thread_mode
+TEST_F(ServerConfigTest, InvalidThreadMode) {
+    auto server_block_stmt = CreateStatement({"server"});
+    server_block_stmt->child_block_ = std::make_unique<NginxConfig>();
+
+    server_block_stmt->child_block_->statements_.push_back(CreateStatement({"thread_mode", "fibers"}));
+
+    auto location_stmt = CreateStatement({"location", "/"});
+    location_stmt->child_block_ = std::make_unique<NginxConfig>();
+    location_stmt->child_block_->statements_.push_back(CreateStatement({"handler", "Echo"}));
+    server_block_stmt->child_block_->statements_.push_back(location_stmt);
+
+    mock_config_.statements_.push_back(server_block_stmt);
+
+    EXPECT_FALSE(server_config_.load_from_nginx_config(mock_config_));
+}
@@ -0,0 +1,142 @@
+#include "stat_cache.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+class StatCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        fs::create_directories(dir_);
+    }
+
+    void TearDown() override {
+        fs::remove_all(dir_);
+    }
+
+    std::string write_file(const std::string& name, const std::string& content) {
+        std::string path = dir_ + "/" + name;
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << content;
+        return path;
+    }
+
+    // The watcher invalidates asynchronously
+    bool wait_until_regular(StatCache& cache, const std::string& path) {
+        for (int i = 0; i < 200; ++i) {
+            if (cache.stat(path).regular) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    }
+
+    std::string dir_ = "./stat_cache_test_files";
+};
+
+// Test: Repeated lookups of a file are answered from the cache
+TEST_F(StatCacheTest, CachesExistingFiles) {
+    StatCache cache(16);
+    ASSERT_TRUE(cache.watching());
+    std::string path = write_file("a.txt", "hello");
+
+    StatCache::Result first = cache.stat(path);
+    EXPECT_TRUE(first.regular);
+    EXPECT_EQ(first.size, 5u);
+    EXPECT_EQ(cache.hits(), 0u);
+
+    StatCache::Result second = cache.stat(path);
+    EXPECT_EQ(second.inode, first.inode);
+    EXPECT_EQ(second.mtime_ns, first.mtime_ns);
+    EXPECT_EQ(cache.hits(), 1u);
+
+    EXPECT_TRUE(cache.stat(dir_).exists);
+    EXPECT_FALSE(cache.stat(dir_).regular);
+}
+
+// Test: Misses are cached too, and dropped when the file appears, even below
+// directories that did not exist yet
+TEST_F(StatCacheTest, CachesMissingFilesUntilCreated) {
+    StatCache cache(16);
+    std::string missing = dir_ + "/missing.txt";
+    std::string nested = dir_ + "/new/dir/file.txt";
+
+    EXPECT_FALSE(cache.stat(missing).exists);
+    EXPECT_FALSE(cache.stat(nested).exists);
+    EXPECT_FALSE(cache.stat(missing).exists);
+    EXPECT_FALSE(cache.stat(nested).exists);
+    EXPECT_EQ(cache.hits(), 2u);
+
+    write_file("missing.txt", "now here");
+    EXPECT_TRUE(wait_until_regular(cache, missing));
+
+    fs::create_directories(dir_ + "/new/dir");
+    write_file("new/dir/file.txt", "nested");
+    EXPECT_TRUE(wait_until_regular(cache, nested));
+}
+
+// Test: Changes to a cached file are picked up through inotify
+TEST_F(StatCacheTest, InvalidatesChangedFiles) {
+    StatCache cache(16, std::chrono::hours(1));
+    std::string path = write_file("a.txt", "hello");
+    ASSERT_EQ(cache.stat(path).size, 5u);
+
+    write_file("a.txt", "hello, world");
+    bool updated = false;
+    for (int i = 0; i < 200 && !updated; ++i) {
+        updated = cache.stat(path).size == 12u;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_TRUE(updated);
+
+    fs::remove(path);
+    bool removed = false;
+    for (int i = 0; i < 200 && !removed; ++i) {
+        removed = !cache.stat(path).exists;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_TRUE(removed);
+}
+
+// Test: Found files are re-checked once the TTL is up
+TEST_F(StatCacheTest, ExistingFilesExpire) {
+    StatCache cache(16, std::chrono::milliseconds(0));
+    std::string path = write_file("a.txt", "hello");
+
+    cache.stat(path);
+    cache.stat(path);
+    EXPECT_EQ(cache.hits(), 0u);
+}
+
+// Test: The least recently used entries go first once the cache is full
+TEST_F(StatCacheTest, EvictsLeastRecentlyUsed) {
+    StatCache cache(2);
+    cache.stat(dir_ + "/a");
+    cache.stat(dir_ + "/b");
+    cache.stat(dir_ + "/a");
+    cache.stat(dir_ + "/c");
+    EXPECT_EQ(cache.entries(), 2u);
+
+    uint64_t hits = cache.hits();
+    cache.stat(dir_ + "/a");
+    EXPECT_EQ(cache.hits(), hits + 1);
+    cache.stat(dir_ + "/b");
+    EXPECT_EQ(cache.hits(), hits + 1);
+}
+
+// Test: Invalidating a directory drops everything below it
+TEST_F(StatCacheTest, InvalidatesSubtrees) {
+    StatCache cache(16);
+    cache.stat(dir_ + "/sub/a");
+    cache.stat(dir_ + "/sub/b");
+    cache.stat(dir_ + "/subway");
+    ASSERT_EQ(cache.entries(), 3u);
+
+    cache.invalidate(dir_ + "/sub");
+    EXPECT_EQ(cache.entries(), 1u);
+}
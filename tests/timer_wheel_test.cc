@@ -0,0 +1,86 @@
+#include "timer_wheel.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <memory>
+
+using namespace std::chrono_literals;
+
+class CountingClient : public TimerWheel::Client {
+public:
+    void on_timeout() override { ++timeouts; }
+    int timeouts = 0;
+};
+
+class TimerWheelTest : public ::testing::Test {
+protected:
+    // The io_service is never run; tests drive the wheel through advance()
+    boost::asio::io_service io_service_;
+    TimerWheel wheel_{io_service_, 100ms, 16};
+    TimerWheel::Clock::time_point start_ = TimerWheel::Clock::now();
+    std::shared_ptr<CountingClient> client_ = std::make_shared<CountingClient>();
+};
+
+// Test: A client fires once its deadline has passed, not before
+TEST_F(TimerWheelTest, FiresAfterDeadline) {
+    wheel_.set_deadline(client_, start_ + 500ms);
+
+    wheel_.advance(start_ + 300ms);
+    EXPECT_EQ(client_->timeouts, 0);
+    EXPECT_FALSE(wheel_.expired(*client_, start_ + 300ms));
+
+    wheel_.advance(start_ + 700ms);
+    EXPECT_EQ(client_->timeouts, 1);
+    EXPECT_TRUE(wheel_.expired(*client_, start_ + 700ms));
+}
+
+// Test: Pushing a deadline back reuses the entry and delays the timeout
+TEST_F(TimerWheelTest, ExtendedDeadlineIsRescheduled) {
+    wheel_.set_deadline(client_, start_ + 200ms);
+    wheel_.set_deadline(client_, start_ + 900ms);
+    EXPECT_EQ(wheel_.size(), 1u);
+
+    wheel_.advance(start_ + 500ms);
+    EXPECT_EQ(client_->timeouts, 0);
+
+    wheel_.advance(start_ + 1000ms);
+    EXPECT_EQ(client_->timeouts, 1);
+}
+
+// Test: Pulling a deadline forward fires at the new time, exactly once
+TEST_F(TimerWheelTest, EarlierDeadlineFiresEarly) {
+    wheel_.set_deadline(client_, start_ + 1000ms);
+    wheel_.set_deadline(client_, start_ + 200ms);
+
+    wheel_.advance(start_ + 400ms);
+    EXPECT_EQ(client_->timeouts, 1);
+
+    wheel_.advance(start_ + 1500ms);
+    EXPECT_EQ(client_->timeouts, 1);
+}
+
+// Test: Deadlines beyond one revolution of the wheel still fire on time
+TEST_F(TimerWheelTest, DeadlinePastHorizon) {
+    wheel_.set_deadline(client_, start_ + 5s);
+
+    wheel_.advance(start_ + 4s);
+    EXPECT_EQ(client_->timeouts, 0);
+
+    wheel_.advance(start_ + 5200ms);
+    EXPECT_EQ(client_->timeouts, 1);
+}
+
+// Test: Cleared deadlines and destroyed clients never fire
+TEST_F(TimerWheelTest, ClearedAndExpiredClientsAreSkipped) {
+    auto other = std::make_shared<CountingClient>();
+    wheel_.set_deadline(client_, start_ + 200ms);
+    wheel_.set_deadline(other, start_ + 200ms);
+
+    wheel_.clear_deadline(*client_);
+    std::weak_ptr<CountingClient> weak_other = other;
+    other.reset();
+
+    wheel_.advance(start_ + 500ms);
+    EXPECT_EQ(client_->timeouts, 0);
+    EXPECT_TRUE(weak_other.expired());
+    EXPECT_EQ(wheel_.size(), 0u);
+}